@@ -314,7 +314,9 @@ HEADERS += \
     src/crypto/argon2d/argon2.h \
     src/crypto/argon2d/core.h \
     src/crypto/argon2d/encoding.h \
+    src/crypto/argon2d/pool.h \
     src/crypto/argon2d/thread.h \
+    src/crypto/argon2d/workers.h \
     src/crypto/blake2/blake2-impl.h \
     src/crypto/blake2/blake2.h \
     src/crypto/blake2/blamka-round-opt.h \
@@ -412,6 +414,7 @@ HEADERS += \
     src/timedata.h \
     src/tinyformat.h \
     src/torcontrol.h \
+    src/trace.h \
     src/txdb.h \
     src/txmempool.h \
     src/ui_interface.h \
@@ -498,9 +501,12 @@ SOURCES += \
     src/crypto/sha512.cpp \
     src/crypto/argon2d/argon2.c \
     src/crypto/argon2d/core.c \
+    src/crypto/argon2d/dispatch.c \
     src/crypto/argon2d/encoding.c \
     src/crypto/argon2d/opt.c \
+    src/crypto/argon2d/pool.cpp \
     src/crypto/argon2d/thread.c \
+    src/crypto/argon2d/workers.cpp \
     src/crypto/blake2/blake2b.c \
     src/policy/fees.cpp \
     src/policy/policy.cpp \
@@ -586,6 +592,7 @@ SOURCES += \
     src/sync.cpp \
     src/timedata.cpp \
     src/torcontrol.cpp \
+    src/trace.cpp \
     src/txdb.cpp \
     src/txmempool.cpp \
     src/uint256.cpp \
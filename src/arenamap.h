@@ -0,0 +1,398 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_ARENAMAP_H
+#define CASH_ARENAMAP_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Hash map with open addressing whose elements live in a chunked arena.
+ *
+ * Elements are constructed in place in chunks of CHUNK_SIZE slots that are
+ * never moved, so there is no heap allocation per element and references and
+ * iterators stay valid until their element is erased, as with
+ * std::unordered_map. Lookups go through a linear probing table of
+ * (hash, slot) pairs; growing the map only rebuilds that table, and never
+ * needs to hash a key again. Erased slots are reused before the arena is
+ * extended; compact() returns the chunks no longer needed and clear() all
+ * memory.
+ *
+ * Iteration walks the arena in slot order, so erasing the current element
+ * while iterating (erase(it++)) is safe. Inserting while iterating is not.
+ *
+ * sweep() approximates least recently used eviction with a clock hand over
+ * the arena: elements inserted or touch()ed since the hand last passed get a
+ * second chance.
+ */
+template <typename K, typename T, typename Hash>
+class arenamap
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef size_t size_type;
+
+    static const uint32_t CHUNK_BITS = 8;
+    static const uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+
+private:
+    static const uint32_t NO_SLOT = 0xffffffff;
+
+    struct bucket {
+        uint32_t hash;
+        uint32_t slot;
+    };
+
+    struct chunk {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type slots[CHUNK_SIZE];
+        uint64_t used[CHUNK_SIZE / 64];
+        uint64_t referenced[CHUNK_SIZE / 64];
+    };
+
+    Hash hasher;
+    std::vector<std::unique_ptr<chunk> > vChunks;
+    //! Power of two sized probing table, or empty
+    std::vector<bucket> vTable;
+    //! Erased slots below nSlots, reused first
+    std::vector<uint32_t> vFree;
+    //! Number of slots handed out from the arena
+    uint32_t nSlots;
+    size_t nSize;
+    //! Next slot visited by sweep()
+    uint32_t nHand;
+
+    value_type* slot_ptr(uint32_t slot) const
+    {
+        return reinterpret_cast<value_type*>(&vChunks[slot >> CHUNK_BITS]->slots[slot & (CHUNK_SIZE - 1)]);
+    }
+
+    uint64_t& used_word(uint32_t slot) const
+    {
+        return vChunks[slot >> CHUNK_BITS]->used[(slot & (CHUNK_SIZE - 1)) >> 6];
+    }
+
+    uint64_t& referenced_word(uint32_t slot) const
+    {
+        return vChunks[slot >> CHUNK_BITS]->referenced[(slot & (CHUNK_SIZE - 1)) >> 6];
+    }
+
+    //! First slot in use at or after slot, or NO_SLOT
+    uint32_t next_used(uint32_t slot) const
+    {
+        while (slot < nSlots) {
+            uint64_t word = used_word(slot) >> (slot & 63);
+            if (word) {
+                while (!(word & 1)) {
+                    word >>= 1;
+                    ++slot;
+                }
+                return slot;
+            }
+            slot = (slot | 63) + 1;
+        }
+        return NO_SLOT;
+    }
+
+    uint32_t hash_of(const K& key) const
+    {
+        uint64_t h = hasher(key);
+        return (uint32_t)h ^ (uint32_t)(h >> 32);
+    }
+
+    //! Table position holding key, or NO_SLOT
+    size_t find_pos(const K& key, uint32_t hash) const
+    {
+        if (vTable.empty())
+            return NO_SLOT;
+        const size_t mask = vTable.size() - 1;
+        for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            const bucket& b = vTable[pos];
+            if (b.slot == NO_SLOT)
+                return NO_SLOT;
+            if (b.hash == hash && slot_ptr(b.slot)->first == key)
+                return pos;
+        }
+    }
+
+    void insert_bucket(uint32_t hash, uint32_t slot)
+    {
+        const size_t mask = vTable.size() - 1;
+        size_t pos = hash & mask;
+        while (vTable[pos].slot != NO_SLOT)
+            pos = (pos + 1) & mask;
+        vTable[pos].hash = hash;
+        vTable[pos].slot = slot;
+    }
+
+    void rehash(size_t nBuckets)
+    {
+        std::vector<bucket> vOld;
+        vOld.swap(vTable);
+        vTable.assign(nBuckets, bucket{0, NO_SLOT});
+        for (const bucket& b : vOld) {
+            if (b.slot != NO_SLOT)
+                insert_bucket(b.hash, b.slot);
+        }
+    }
+
+    uint32_t alloc_slot()
+    {
+        if (!vFree.empty()) {
+            uint32_t slot = vFree.back();
+            vFree.pop_back();
+            return slot;
+        }
+        assert(nSlots < NO_SLOT);
+        if (nSlots == vChunks.size() * CHUNK_SIZE) {
+            vChunks.emplace_back(new chunk);
+            memset(vChunks.back()->used, 0, sizeof(vChunks.back()->used));
+            memset(vChunks.back()->referenced, 0, sizeof(vChunks.back()->referenced));
+        }
+        return nSlots++;
+    }
+
+    void erase_slot(uint32_t slot)
+    {
+        value_type* p = slot_ptr(slot);
+        const size_t mask = vTable.size() - 1;
+        size_t hole = find_pos(p->first, hash_of(p->first));
+        assert(hole != NO_SLOT && vTable[hole].slot == slot);
+        // Backward shift deletion: move later members of the probe sequence
+        // into the hole unless that would put them before their home bucket.
+        for (size_t pos = (hole + 1) & mask; vTable[pos].slot != NO_SLOT; pos = (pos + 1) & mask) {
+            size_t home = vTable[pos].hash & mask;
+            if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+                vTable[hole] = vTable[pos];
+                hole = pos;
+            }
+        }
+        vTable[hole].slot = NO_SLOT;
+
+        p->~value_type();
+        used_word(slot) &= ~((uint64_t)1 << (slot & 63));
+        vFree.push_back(slot);
+        --nSize;
+    }
+
+    template <bool IsConst>
+    class iterator_base
+    {
+        friend class arenamap;
+        friend class iterator_base<!IsConst>;
+        typedef typename std::conditional<IsConst, const arenamap*, arenamap*>::type map_pointer;
+
+        map_pointer map;
+        uint32_t slot;
+
+        iterator_base(map_pointer mapIn, uint32_t slotIn) : map(mapIn), slot(slotIn) {}
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::conditional<IsConst, const typename arenamap::value_type, typename arenamap::value_type>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef value_type* pointer;
+        typedef value_type& reference;
+
+        iterator_base() : map(nullptr), slot(NO_SLOT) {}
+        template <bool OtherConst, typename std::enable_if<IsConst && !OtherConst, int>::type = 0>
+        iterator_base(const iterator_base<OtherConst>& other) : map(other.map), slot(other.slot) {}
+
+        reference operator*() const { return *map->slot_ptr(slot); }
+        pointer operator->() const { return map->slot_ptr(slot); }
+        iterator_base& operator++()
+        {
+            slot = map->next_used(slot + 1);
+            return *this;
+        }
+        iterator_base operator++(int)
+        {
+            iterator_base copy(*this);
+            ++(*this);
+            return copy;
+        }
+        bool operator==(const iterator_base& other) const { return slot == other.slot; }
+        bool operator!=(const iterator_base& other) const { return slot != other.slot; }
+    };
+
+public:
+    typedef iterator_base<false> iterator;
+    typedef iterator_base<true> const_iterator;
+
+    arenamap() : nSlots(0), nSize(0), nHand(0) {}
+    arenamap(const arenamap&) = delete;
+    arenamap& operator=(const arenamap&) = delete;
+    ~arenamap() { clear(); }
+
+    iterator begin() { return iterator(this, next_used(0)); }
+    const_iterator begin() const { return const_iterator(this, next_used(0)); }
+    iterator end() { return iterator(this, NO_SLOT); }
+    const_iterator end() const { return const_iterator(this, NO_SLOT); }
+
+    size_type size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+
+    iterator find(const K& key)
+    {
+        size_t pos = find_pos(key, hash_of(key));
+        return iterator(this, pos == NO_SLOT ? NO_SLOT : vTable[pos].slot);
+    }
+    const_iterator find(const K& key) const
+    {
+        size_t pos = find_pos(key, hash_of(key));
+        return const_iterator(this, pos == NO_SLOT ? NO_SLOT : vTable[pos].slot);
+    }
+    size_type count(const K& key) const { return find_pos(key, hash_of(key)) == NO_SLOT ? 0 : 1; }
+
+    /** Construct the value for key from args, unless key is already present. */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+        const uint32_t hash = hash_of(key);
+        size_t pos = find_pos(key, hash);
+        if (pos != NO_SLOT)
+            return std::make_pair(iterator(this, vTable[pos].slot), false);
+        // Keep the load factor at or below 3/4.
+        if ((nSize + 1) * 4 > vTable.size() * 3)
+            rehash(vTable.empty() ? 16 : vTable.size() * 2);
+        const uint32_t slot = alloc_slot();
+        try {
+            new (slot_ptr(slot)) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            vFree.push_back(slot);
+            throw;
+        }
+        used_word(slot) |= (uint64_t)1 << (slot & 63);
+        referenced_word(slot) |= (uint64_t)1 << (slot & 63);
+        insert_bucket(hash, slot);
+        ++nSize;
+        return std::make_pair(iterator(this, slot), true);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> emplace(const K& key, V&& value)
+    {
+        return try_emplace(key, std::forward<V>(value));
+    }
+
+    T& operator[](const K& key) { return try_emplace(key).first->second; }
+
+    void erase(const_iterator it) { erase_slot(it.slot); }
+
+    size_type erase(const K& key)
+    {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase_slot(it.slot);
+        return 1;
+    }
+
+    void clear()
+    {
+        for (uint32_t slot = next_used(0); slot != NO_SLOT; slot = next_used(slot + 1))
+            slot_ptr(slot)->~value_type();
+        std::vector<std::unique_ptr<chunk> >().swap(vChunks);
+        std::vector<bucket>().swap(vTable);
+        std::vector<uint32_t>().swap(vFree);
+        nSlots = 0;
+        nSize = 0;
+        nHand = 0;
+    }
+
+    /**
+     * Move the elements into as few arena chunks as they need, releasing the
+     * chunks and table space left over by erasing. Recently used marks are
+     * kept. Invalidates all iterators and references.
+     */
+    void compact()
+    {
+        if (nSize == 0) {
+            clear();
+            return;
+        }
+        arenamap other;
+        size_t nBuckets = 16;
+        while (nSize * 4 > nBuckets * 3)
+            nBuckets *= 2;
+        other.vTable.assign(nBuckets, bucket{0, NO_SLOT});
+        for (const bucket& b : vTable) {
+            if (b.slot == NO_SLOT)
+                continue;
+            const uint32_t slot = other.alloc_slot();
+            new (other.slot_ptr(slot)) value_type(std::move(*slot_ptr(b.slot)));
+            const uint64_t bit = (uint64_t)1 << (slot & 63);
+            other.used_word(slot) |= bit;
+            if (referenced_word(b.slot) & ((uint64_t)1 << (b.slot & 63)))
+                other.referenced_word(slot) |= bit;
+            other.insert_bucket(b.hash, slot);
+            ++other.nSize;
+        }
+        clear();
+        vChunks.swap(other.vChunks);
+        vTable.swap(other.vTable);
+        std::swap(nSlots, other.nSlots);
+        std::swap(nSize, other.nSize);
+    }
+
+    //! Mark an element as recently used, so that the next sweep() passes over it.
+    void touch(const_iterator it)
+    {
+        referenced_word(it.slot) |= (uint64_t)1 << (it.slot & 63);
+    }
+
+    /**
+     * Advance the clock hand, clearing the mark of recently used elements and
+     * calling fEvict(value) for the others; elements for which it returns true
+     * are erased. Stops as soon as fDone() returns true, or after the hand went
+     * around twice. Returns the number of erased elements.
+     */
+    template <typename Evict, typename Done>
+    size_t sweep(Evict fEvict, Done fDone)
+    {
+        size_t nErased = 0;
+        for (uint64_t nSteps = 2 * (uint64_t)nSlots; nSteps > 0 && !fDone(); nSteps--) {
+            if (nHand >= nSlots)
+                nHand = 0;
+            const uint32_t slot = nHand++;
+            const uint64_t bit = (uint64_t)1 << (slot & 63);
+            if (!(used_word(slot) & bit))
+                continue;
+            if (referenced_word(slot) & bit) {
+                referenced_word(slot) &= ~bit;
+                continue;
+            }
+            if (fEvict(*slot_ptr(slot))) {
+                erase_slot(slot);
+                ++nErased;
+            }
+        }
+        return nErased;
+    }
+
+    //! Number of arena chunks allocated, each of chunk_bytes() bytes
+    size_t chunk_count() const { return vChunks.size(); }
+    //! Arena chunks the current elements need. Erased slots stay allocated until
+    //! compact() or clear(), so up to chunk_count() may be held.
+    size_t chunks_in_use() const { return (nSize + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+    static size_t chunk_bytes() { return sizeof(chunk); }
+    size_t bucket_count() const { return vTable.size(); }
+    //! Bytes held by the probing table and bookkeeping vectors
+    size_t index_bytes() const
+    {
+        return vTable.capacity() * sizeof(bucket) + vFree.capacity() * sizeof(uint32_t) + vChunks.capacity() * sizeof(std::unique_ptr<chunk>);
+    }
+};
+
+#endif // CASH_ARENAMAP_H
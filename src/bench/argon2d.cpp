@@ -0,0 +1,83 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "hash.h"
+#include "pow.h"
+#include "primitives/block.h"
+#include "utiltime.h"
+
+static CBlockHeader BenchHeader()
+{
+    CBlockHeader header = Params().GenesisBlock().GetBlockHeader();
+    header.nTime = GetTime();
+    return header;
+}
+
+static void Argon2dPhase(benchmark::State& state, unsigned int hashPhase)
+{
+    CBlockHeader header = BenchHeader();
+    state.SetItemsPerIteration(1);
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        hash_Argon2d(BEGIN(header.nVersion), END(header.nNonce), hashPhase);
+    }
+}
+
+static void Argon2dPhase0(benchmark::State& state)
+{
+    Argon2dPhase(state, 0);
+}
+
+static void Argon2dPhase1(benchmark::State& state)
+{
+    Argon2dPhase(state, 1);
+}
+
+static void Argon2dPhase2(benchmark::State& state)
+{
+    Argon2dPhase(state, 2);
+}
+
+// Uncached header hash in the phase active now, including the phase lookup
+static void BlockHeaderGetHash(benchmark::State& state)
+{
+    CBlockHeader header = BenchHeader();
+    state.SetItemsPerIteration(1);
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        header.GetHash();
+    }
+}
+
+// Header hash already known, as for a header that was checked before
+static void BlockHeaderGetHashCached(benchmark::State& state)
+{
+    CBlockHeader header = BenchHeader();
+    header.GetHash();
+    state.SetItemsPerIteration(1);
+    while (state.KeepRunning()) {
+        header.GetHash();
+    }
+}
+
+// Target comparison only, the hash is computed once
+static void CheckProofOfWorkTarget(benchmark::State& state)
+{
+    const CBlock& genesis = Params().GenesisBlock();
+    const uint256 hash = genesis.GetHash();
+    const Consensus::Params& consensus = Params().GetConsensus();
+    while (state.KeepRunning()) {
+        CheckProofOfWork(hash, genesis.nBits, consensus);
+    }
+}
+
+BENCHMARK(Argon2dPhase0);
+BENCHMARK(Argon2dPhase1);
+BENCHMARK(Argon2dPhase2);
+BENCHMARK(BlockHeaderGetHash);
+BENCHMARK(BlockHeaderGetHashCached);
+BENCHMARK(CheckProofOfWorkTarget);
@@ -5,11 +5,13 @@
 #include "bench.h"
 
 #include <iostream>
+#include <regex>
 #include <sys/time.h>
 
 using namespace benchmark;
 
 std::map<std::string, BenchFunction> BenchRunner::benchmarks;
+std::vector<Result> BenchRunner::results;
 
 static double gettimedouble(void) {
     struct timeval tv;
@@ -23,17 +25,42 @@ BenchRunner::BenchRunner(std::string name, BenchFunction func)
 }
 
 void
-BenchRunner::RunAll(double elapsedTimeForOne)
+BenchRunner::RunAll(double elapsedTimeForOne, const std::string& filter, int64_t iterations, OutputFormat format)
 {
-    std::cout << "Benchmark" << "," << "count" << "," << "min" << "," << "max" << "," << "average" << "\n";
+    std::regex reFilter(filter);
+    results.clear();
 
     for (std::map<std::string,BenchFunction>::iterator it = benchmarks.begin();
          it != benchmarks.end(); ++it) {
 
-        State state(it->first, elapsedTimeForOne);
+        if (!std::regex_match(it->first, reFilter))
+            continue;
+        State state(it->first, elapsedTimeForOne, iterations);
         BenchFunction& func = it->second;
         func(state);
     }
+
+    // Results are printed at the end so that the output stays machine-readable
+    if (format == OutputFormat::JSON) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::cout << "  {\"name\": \"" << r.name << "\", \"count\": " << r.count << ", \"min\": " << r.minTime
+                      << ", \"max\": " << r.maxTime << ", \"average\": " << r.average << ", \"itemspersec\": " << r.itemsPerSecond
+                      << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "Benchmark" << "," << "count" << "," << "min" << "," << "max" << "," << "average" << "," << "itemspersec" << "\n";
+        for (const Result& r : results)
+            std::cout << r.name << "," << r.count << "," << r.minTime << "," << r.maxTime << "," << r.average << "," << r.itemsPerSecond << "\n";
+    }
+}
+
+void
+BenchRunner::Report(const Result& result)
+{
+    results.push_back(result);
 }
 
 bool State::KeepRunning()
@@ -53,18 +80,25 @@ bool State::KeepRunning()
         double elapsedOne = (now - lastTime)/timeCheckCount;
         if (elapsedOne < minTime) minTime = elapsedOne;
         if (elapsedOne > maxTime) maxTime = elapsedOne;
-        if (elapsedOne*timeCheckCount < maxElapsed/16) timeCheckCount *= 2;
+        // A fixed iteration count times every iteration
+        if (maxIterations == 0 && elapsedOne*timeCheckCount < maxElapsed/16) timeCheckCount *= 2;
     }
     lastTime = now;
     ++count;
 
-    if (now - beginTime < maxElapsed) return true; // Keep going
+    if (maxIterations > 0 ? count <= maxIterations : now - beginTime < maxElapsed) return true; // Keep going
 
     --count;
 
-    // Output results
-    double average = (now-beginTime)/count;
-    std::cout << name << "," << count << "," << minTime << "," << maxTime << "," << average << "\n";
+    // Record results
+    Result result;
+    result.name = name;
+    result.count = count;
+    result.minTime = minTime;
+    result.maxTime = maxTime;
+    result.average = count > 0 ? (now-beginTime)/count : 0;
+    result.itemsPerSecond = result.average > 0 ? itemsPerIteration / result.average : 0;
+    BenchRunner::Report(result);
 
     return false;
 }
@@ -5,8 +5,10 @@
 #ifndef CASH_BENCH_BENCH_H
 #define CASH_BENCH_BENCH_H
 
+#include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/function.hpp>
 #include <boost/preprocessor/cat.hpp>
@@ -36,20 +38,38 @@ BENCHMARK(CODE_TO_TIME);
  
 namespace benchmark {
 
+    /** Timing of one benchmark, all times in seconds per iteration */
+    struct Result {
+        std::string name;
+        int64_t count;
+        double minTime, maxTime, average;
+        double itemsPerSecond;
+    };
+
+    enum class OutputFormat {
+        CSV,
+        JSON,
+    };
+
     class State {
         std::string name;
         double maxElapsed;
+        int64_t maxIterations;
         double beginTime;
         double lastTime, minTime, maxTime;
         int64_t count;
         int64_t timeCheckCount;
+        int64_t itemsPerIteration;
     public:
-        State(std::string _name, double _maxElapsed) : name(_name), maxElapsed(_maxElapsed), count(0) {
+        /** Runs for maxElapsed seconds, or exactly maxIterations times when it is not zero */
+        State(std::string _name, double _maxElapsed, int64_t _maxIterations = 0) : name(_name), maxElapsed(_maxElapsed), maxIterations(_maxIterations), count(0), itemsPerIteration(0) {
             minTime = std::numeric_limits<double>::max();
             maxTime = std::numeric_limits<double>::min();
             timeCheckCount = 1;
         }
         bool KeepRunning();
+        /** Reports a throughput of n items (hashes, blocks, ...) per iteration */
+        void SetItemsPerIteration(int64_t n) { itemsPerIteration = n; }
     };
 
     typedef boost::function<void(State&)> BenchFunction;
@@ -57,11 +77,16 @@ namespace benchmark {
     class BenchRunner
     {
         static std::map<std::string, BenchFunction> benchmarks;
+        static std::vector<Result> results;
 
     public:
         BenchRunner(std::string name, BenchFunction func);
 
-        static void RunAll(double elapsedTimeForOne=1.0);
+        /** Runs benchmarks whose name matches filter, then prints all results */
+        static void RunAll(double elapsedTimeForOne=1.0, const std::string& filter=".*", int64_t iterations=0, OutputFormat format=OutputFormat::CSV);
+
+        /** Records a result, for benchmarks that time a part of their loop themselves */
+        static void Report(const Result& result);
     };
 }
 
@@ -4,20 +4,54 @@
 
 #include "bench.h"
 
+#include "chainparams.h"
+#include "chainparamsbase.h"
 #include "key.h"
 #include "random.h"
 #include "validation.h"
 #include "util.h"
 
+#include <iostream>
+
+static const double DEFAULT_BENCH_TIME = 1.0;
+static const char* DEFAULT_BENCH_FILTER = ".*";
+static const char* DEFAULT_BENCH_FORMAT = "csv";
+
 int
 main(int argc, char** argv)
 {
+    ParseParameters(argc, argv);
+
+    if (IsArgSet("-?") || IsArgSet("-h") || IsArgSet("-help")) {
+        std::cout << "Usage: bench_cash [options]\n\n"
+                  << HelpMessageOpt("-?", "Print this help message and exit")
+                  << HelpMessageOpt("-filter=<regex>", strprintf("Regular expression filter to select benchmark by name (default: %s)", DEFAULT_BENCH_FILTER))
+                  << HelpMessageOpt("-time=<seconds>", strprintf("Time to run each benchmark for (default: %.1f)", DEFAULT_BENCH_TIME))
+                  << HelpMessageOpt("-iterations=<n>", "Run each benchmark exactly <n> iterations instead of for a fixed time (default: 0)")
+                  << HelpMessageOpt("-format=<csv|json>", strprintf("Output format (default: %s)", DEFAULT_BENCH_FORMAT));
+        return 0;
+    }
+
+    benchmark::OutputFormat format;
+    std::string strFormat = GetArg("-format", DEFAULT_BENCH_FORMAT);
+    if (strFormat == "csv") {
+        format = benchmark::OutputFormat::CSV;
+    } else if (strFormat == "json") {
+        format = benchmark::OutputFormat::JSON;
+    } else {
+        std::cerr << "Error: unknown output format " << strFormat << "\n";
+        return 1;
+    }
+    double elapsedTimeForOne = std::max(0.0, atof(GetArg("-time", std::to_string(DEFAULT_BENCH_TIME)).c_str()));
+    int64_t iterations = std::max<int64_t>(0, GetArg("-iterations", 0));
+
     RandomInit();
     ECC_Start();
     SetupEnvironment();
+    SelectParams(CBaseChainParams::MAIN);
     fPrintToDebugLog = false; // don't want to write to debug.log file
 
-    benchmark::BenchRunner::RunAll();
+    benchmark::BenchRunner::RunAll(elapsedTimeForOne, GetArg("-filter", DEFAULT_BENCH_FILTER), iterations, format);
 
     ECC_Stop();
 }
@@ -0,0 +1,52 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain_setup.h"
+
+#include "coins.h"
+#include "random.h"
+#include "txdb.h"
+
+/** Coins written per flush */
+static const size_t BENCH_FLUSH_COINS = 10000;
+
+static void AddBenchCoins(CCoinsViewCache& cache, const CScript& scriptPubKey)
+{
+    const uint256 txid = GetRandHash();
+    for (size_t i = 0; i < BENCH_FLUSH_COINS; i++)
+        cache.AddCoin(COutPoint(txid, i), Coin(CTxOut(COIN, scriptPubKey), 1, false), false);
+}
+
+// Block connection view flushed into the in-memory coins cache (CCoinsViewCache::BatchWrite)
+static void CoinsCacheBatchWrite(benchmark::State& state)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    CCoinsView base;
+    state.SetItemsPerIteration(BENCH_FLUSH_COINS);
+    while (state.KeepRunning()) {
+        // A fresh parent each time, so every flush writes into a cache of the same size
+        CCoinsViewCache parent(&base);
+        CCoinsViewCache view(&parent);
+        AddBenchCoins(view, scriptPubKey);
+        view.Flush();
+    }
+}
+
+// Coins cache flushed into the chainstate database, on an in-memory LevelDB (CCoinsViewDB::BatchWrite)
+static void CoinsCacheFlushToDB(benchmark::State& state)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    BenchDataDir datadir;
+    CCoinsViewDB db(1 << 23, true);
+    state.SetItemsPerIteration(BENCH_FLUSH_COINS);
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&db);
+        AddBenchCoins(cache, scriptPubKey);
+        cache.Flush();
+    }
+}
+
+BENCHMARK(CoinsCacheBatchWrite);
+BENCHMARK(CoinsCacheFlushToDB);
@@ -0,0 +1,113 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chain_setup.h"
+
+#include "chainparams.h"
+#include "chainparamsbase.h"
+#include "consensus/validation.h"
+#include "miner/miner-util.h"
+#include "random.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "txdb.h"
+#include "txmempool.h"
+#include "util.h"
+#include "validation.h"
+
+/** Value of each funded output, and the fee its spend pays */
+static const CAmount BENCH_COIN_VALUE = COIN;
+static const CAmount BENCH_SPEND_FEE = 10000;
+
+BenchDataDir::BenchDataDir()
+{
+    pathTemp = boost::filesystem::temp_directory_path() / strprintf("bench_cash_%lu_%i", (unsigned long)GetTime(), (int)(GetRand(100000)));
+    boost::filesystem::create_directories(pathTemp);
+    ForceSetArg("-datadir", pathTemp.string());
+    ClearDatadirCache();
+}
+
+BenchDataDir::~BenchDataDir()
+{
+    ClearDatadirCache();
+    boost::filesystem::remove_all(pathTemp);
+}
+
+BenchChainSetup::BenchChainSetup(size_t nCoins)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const CChainParams& chainparams = Params();
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    pcoinsdbview = new CCoinsViewDB(1 << 23, true);
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+    if (!InitBlockIndex(chainparams))
+        throw std::runtime_error("bench: InitBlockIndex failed");
+    CValidationState state;
+    if (!ActivateBestChain(state, chainparams))
+        throw std::runtime_error("bench: ActivateBestChain failed");
+
+    key.MakeNewKey(true);
+    keystore.AddKey(key);
+    scriptPubKey = CScript() << OP_DUP << OP_HASH160 << ToByteVector(key.GetPubKey().GetID()) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    // Funding outputs go straight into the chainstate
+    CMutableTransaction mtxFunding;
+    mtxFunding.vin.resize(1);
+    mtxFunding.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    mtxFunding.vout.assign(nCoins, CTxOut(BENCH_COIN_VALUE, scriptPubKey));
+    funding = MakeTransactionRef(mtxFunding);
+    {
+        LOCK(cs_main);
+        AddCoins(*pcoinsTip, *funding, chainActive.Height());
+    }
+
+    for (size_t i = 0; i < nCoins; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout = COutPoint(funding->GetHash(), i);
+        mtx.vout.resize(1);
+        mtx.vout[0] = CTxOut(BENCH_COIN_VALUE - BENCH_SPEND_FEE, scriptPubKey);
+        if (!SignSignature(keystore, *funding, mtx, 0))
+            throw std::runtime_error("bench: SignSignature failed");
+        vSpends.push_back(MakeTransactionRef(mtx));
+    }
+}
+
+BenchChainSetup::~BenchChainSetup()
+{
+    mempool.clear();
+    UnloadBlockIndex();
+    delete pcoinsTip;
+    delete pcoinsdbview;
+    delete pblocktree;
+    pcoinsTip = NULL;
+    pcoinsdbview = NULL;
+    pblocktree = NULL;
+    SelectParams(CBaseChainParams::MAIN);
+}
+
+CBlock BenchChainSetup::CreateBlock(size_t nTx) const
+{
+    // An empty template gives the coinbase, payments and header fields for the tip
+    std::unique_ptr<CBlockTemplate> pblocktemplate = CreateNewBlock(Params(), scriptPubKey);
+    if (!pblocktemplate)
+        throw std::runtime_error("bench: CreateNewBlock failed");
+    CBlock block = pblocktemplate->block;
+    block.vtx.resize(1);
+    block.vtx.insert(block.vtx.end(), vSpends.begin(), vSpends.begin() + std::min(nTx, vSpends.size()));
+    unsigned int nExtraNonce = 0;
+    LOCK(cs_main);
+    IncrementExtraNonce(block, chainActive.Tip(), nExtraNonce);
+    return block;
+}
+
+void BenchChainSetup::FillMempool(size_t nTx) const
+{
+    LOCK(cs_main);
+    for (size_t i = 0; i < nTx && i < vSpends.size(); i++) {
+        CValidationState state;
+        if (!AcceptToMemoryPool(mempool, state, vSpends[i], false, NULL))
+            throw std::runtime_error("bench: AcceptToMemoryPool failed: " + FormatStateMessage(state));
+    }
+}
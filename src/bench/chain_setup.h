@@ -0,0 +1,61 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_BENCH_CHAIN_SETUP_H
+#define CASH_BENCH_CHAIN_SETUP_H
+
+#include "key.h"
+#include "keystore.h"
+#include "primitives/block.h"
+#include "pubkey.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+/** Scratch data directory, removed again when done */
+class BenchDataDir
+{
+public:
+    BenchDataDir();
+    ~BenchDataDir();
+
+private:
+    boost::filesystem::path pathTemp;
+};
+
+/**
+ * Synthetic regtest chain for the validation benchmarks.
+ *
+ * The block index and chainstate live in memory (memenv). Instead of mining
+ * a funding history, whose Argon2d proof-of-work would dominate the setup,
+ * nCoins outputs to a single key are added straight to the UTXO set, and
+ * vSpends holds one signed transaction spending each of them.
+ */
+class BenchChainSetup
+{
+public:
+    explicit BenchChainSetup(size_t nCoins);
+    ~BenchChainSetup();
+
+    /** Block on the tip with a valid coinbase and the first nTx spends, proof-of-work not solved */
+    CBlock CreateBlock(size_t nTx) const;
+
+    /** Adds the first nTx spends to the mempool */
+    void FillMempool(size_t nTx) const;
+
+    CKey key;
+    CBasicKeyStore keystore;
+    CScript scriptPubKey;
+    CTransactionRef funding;
+    std::vector<CTransactionRef> vSpends;
+
+private:
+    ECCVerifyHandle verifyHandle;
+    BenchDataDir datadir;
+};
+
+#endif // CASH_BENCH_CHAIN_SETUP_H
@@ -0,0 +1,97 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain_setup.h"
+
+#include "chainparams.h"
+#include "checkqueue.h"
+#include "consensus/validation.h"
+#include "policy/policy.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/thread.hpp>
+
+/**
+ * ConnectBlock is internal to validation.cpp; TestBlockValidity runs it with
+ * fJustCheck on a scratch view over pcoinsTip, after the context-free and
+ * contextual block checks, so the chainstate is left untouched between
+ * iterations. Proof-of-work is not checked, see the Argon2d benchmarks.
+ */
+static void ConnectBlockTxs(benchmark::State& state, size_t nTx)
+{
+    BenchChainSetup setup(nTx);
+    const CBlock block = setup.CreateBlock(nTx);
+    const CChainParams& chainparams = Params();
+    state.SetItemsPerIteration(nTx);
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        CValidationState validationState;
+        if (!TestBlockValidity(validationState, chainparams, block, chainActive.Tip(), false, true))
+            throw std::runtime_error("bench: TestBlockValidity failed: " + FormatStateMessage(validationState));
+    }
+}
+
+static void ConnectBlock100Txs(benchmark::State& state)
+{
+    ConnectBlockTxs(state, 100);
+}
+
+static void ConnectBlock1000Txs(benchmark::State& state)
+{
+    ConnectBlockTxs(state, 1000);
+}
+
+/** Transactions checked per CheckInputs iteration */
+static const size_t BENCH_CHECKINPUTS_TXS = 500;
+
+// Script checks run inline, as with -par=1
+static void CheckInputsSerial(benchmark::State& state)
+{
+    BenchChainSetup setup(BENCH_CHECKINPUTS_TXS);
+    state.SetItemsPerIteration(BENCH_CHECKINPUTS_TXS);
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        for (const auto& tx : setup.vSpends) {
+            CValidationState validationState;
+            if (!CheckInputs(*tx, validationState, *pcoinsTip, true, STANDARD_SCRIPT_VERIFY_FLAGS, false))
+                throw std::runtime_error("bench: CheckInputs failed");
+        }
+    }
+}
+
+// Script checks handed to a check queue with a worker per core, as ConnectBlock does with scriptcheckqueue
+static void CheckInputsQueue(benchmark::State& state)
+{
+    BenchChainSetup setup(BENCH_CHECKINPUTS_TXS);
+    CCheckQueue<CScriptCheck> queue(128);
+    boost::thread_group threadGroup;
+    const int nWorkers = std::max(1, std::min(GetNumCores(), MAX_SCRIPTCHECK_THREADS) - 1);
+    for (int i = 0; i < nWorkers; i++)
+        threadGroup.create_thread(boost::bind(&CCheckQueue<CScriptCheck>::Thread, &queue));
+
+    state.SetItemsPerIteration(BENCH_CHECKINPUTS_TXS);
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        CCheckQueueControl<CScriptCheck> control(&queue);
+        for (const auto& tx : setup.vSpends) {
+            CValidationState validationState;
+            std::vector<CScriptCheck> vChecks;
+            if (!CheckInputs(*tx, validationState, *pcoinsTip, true, STANDARD_SCRIPT_VERIFY_FLAGS, false, &vChecks))
+                throw std::runtime_error("bench: CheckInputs failed");
+            control.Add(vChecks);
+        }
+        if (!control.Wait())
+            throw std::runtime_error("bench: script checks failed");
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BENCHMARK(ConnectBlock100Txs);
+BENCHMARK(ConnectBlock1000Txs);
+BENCHMARK(CheckInputsSerial);
+BENCHMARK(CheckInputsQueue);
@@ -0,0 +1,40 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain_setup.h"
+
+#include "chainparams.h"
+#include "miner/miner-util.h"
+#include "txmempool.h"
+#include "validation.h"
+
+/** Transactions in the mempool for the mempool benchmarks */
+static const size_t BENCH_MEMPOOL_TXS = 1000;
+
+// Each iteration accepts every transaction into an empty mempool, clearing it is included
+static void AcceptToMemoryPoolBench(benchmark::State& state)
+{
+    BenchChainSetup setup(BENCH_MEMPOOL_TXS);
+    state.SetItemsPerIteration(BENCH_MEMPOOL_TXS);
+    while (state.KeepRunning()) {
+        setup.FillMempool(BENCH_MEMPOOL_TXS);
+        mempool.clear();
+    }
+}
+
+// Template assembly, including its TestBlockValidity, from a full mempool
+static void CreateNewBlockFullMempool(benchmark::State& state)
+{
+    BenchChainSetup setup(BENCH_MEMPOOL_TXS);
+    setup.FillMempool(BENCH_MEMPOOL_TXS);
+    state.SetItemsPerIteration(BENCH_MEMPOOL_TXS);
+    while (state.KeepRunning()) {
+        if (!CreateNewBlock(Params(), setup.scriptPubKey))
+            throw std::runtime_error("bench: CreateNewBlock failed");
+    }
+}
+
+BENCHMARK(AcceptToMemoryPoolBench);
+BENCHMARK(CreateNewBlockFullMempool);
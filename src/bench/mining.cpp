@@ -0,0 +1,159 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "crypto/argon2d/workers.h"
+#include "miner/impl/argon2d-scanner.h"
+#include "pow.h"
+#include "primitives/block.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Nonces each thread scans per iteration; CPUMiner uses DEFAULT_CPU_SCAN_BATCH between template checks */
+static const std::size_t BENCH_SCAN_BATCH = 8;
+
+/**
+ * Runs the CPU miner's nonce scan on nThreads persistent threads, as many
+ * CPUMiner threads would, one batch per thread per iteration. The threads
+ * outlive the iterations so their Argon2d arenas are allocated only once.
+ */
+static void MinerScanThreads(benchmark::State& state, int nThreads)
+{
+    CBlockHeader header = Params().GenesisBlock().GetBlockHeader();
+    header.nTime = GetTime();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t round = 0;
+    int pending = 0;
+    bool stop = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; i++) {
+        threads.emplace_back([&, i] {
+            Argon2dSetThreadParallel(false);
+            Argon2dScanner scanner(BENCH_SCAN_BATCH);
+            uint32_t nonce = (uint32_t)i << 24;
+            uint64_t done = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return stop || round != done; });
+                if (stop)
+                    return;
+                done = round;
+                lock.unlock();
+                // A zero target never matches, as while searching for a block
+                uint32_t result_nonce;
+                scanner.scanNonces(header, nonce, 0, result_nonce);
+                nonce += BENCH_SCAN_BATCH;
+                lock.lock();
+                if (--pending == 0)
+                    cv.notify_all();
+            }
+        });
+    }
+
+    state.SetItemsPerIteration(nThreads * BENCH_SCAN_BATCH);
+    while (state.KeepRunning()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending = nThreads;
+        round++;
+        cv.notify_all();
+        cv.wait(lock, [&] { return pending == 0; });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+static void MinerScan1Thread(benchmark::State& state)
+{
+    MinerScanThreads(state, 1);
+}
+
+static void MinerScan2Threads(benchmark::State& state)
+{
+    MinerScanThreads(state, 2);
+}
+
+static void MinerScan4Threads(benchmark::State& state)
+{
+    MinerScanThreads(state, 4);
+}
+
+static void MinerScanAllCores(benchmark::State& state)
+{
+    MinerScanThreads(state, std::max(1, GetNumCores()));
+}
+
+/** Block indexes in a chain covering the longest averaging window */
+static const size_t BENCH_CHAIN_LENGTH = 12000;
+
+/** Chain of block indexes spaced at the target spacing, past the last difficulty switch height */
+class BenchChain
+{
+public:
+    std::vector<CBlockIndex> vIndex;
+
+    explicit BenchChain(size_t nLength) : vIndex(nLength)
+    {
+        const Consensus::Params& consensus = Params().GetConsensus();
+        const int nStartHeight = std::max<int>(consensus.nUpdateDiffAlgoHeight, Params().FirstDifficultySwitchBlock()) + 1;
+        const unsigned int nBits = UintToArith256(consensus.powLimit).GetCompact();
+        for (size_t i = 0; i < vIndex.size(); i++) {
+            CBlockIndex& index = vIndex[i];
+            index.pprev = i > 0 ? &vIndex[i - 1] : nullptr;
+            index.nHeight = nStartHeight + i;
+            index.nTime = 1500000000 + i * consensus.GetCurrentPowTargetSpacing(index.nHeight);
+            index.nBits = nBits;
+        }
+    }
+
+    const CBlockIndex* Tip() const { return &vIndex.back(); }
+};
+
+static void GetNextWorkRequiredBench(benchmark::State& state)
+{
+    BenchChain chain(BENCH_CHAIN_LENGTH);
+    CBlockHeader header;
+    header.nTime = chain.Tip()->nTime + 60;
+    const Consensus::Params& consensus = Params().GetConsensus();
+    while (state.KeepRunning()) {
+        GetNextWorkRequired(chain.Tip(), header, consensus);
+    }
+}
+
+static void DigiShieldBench(benchmark::State& state)
+{
+    BenchChain chain(BENCH_CHAIN_LENGTH);
+    const Consensus::Params& consensus = Params().GetConsensus();
+    const int nHeight = chain.Tip()->nHeight + 1;
+    const int64_t nWindow = consensus.GetCurrentPowAveragingWindow(nHeight);
+    const int64_t nTimespan = consensus.AveragingWindowTimespan(nHeight);
+    const int64_t nMinTimespan = consensus.MinActualTimespan(nHeight);
+    const int64_t nMaxTimespan = consensus.MaxActualTimespan(nHeight);
+    while (state.KeepRunning()) {
+        DigiShield(chain.Tip(), nWindow, nTimespan, nMinTimespan, nMaxTimespan, consensus);
+    }
+}
+
+BENCHMARK(MinerScan1Thread);
+BENCHMARK(MinerScan2Threads);
+BENCHMARK(MinerScan4Threads);
+BENCHMARK(MinerScanAllCores);
+BENCHMARK(GetNextWorkRequiredBench);
+BENCHMARK(DigiShieldBench);
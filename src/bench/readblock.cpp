@@ -0,0 +1,73 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain_setup.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "consensus/merkle.h"
+#include "primitives/block.h"
+#include "util.h"
+#include "validation.h"
+
+/** Transactions in the block read by ReadBlockFromDiskIndex */
+static const int BENCH_BLOCK_TXS = 1000;
+
+static CDiskBlockPos WriteBenchBlock(const CBlock& block, int nFile)
+{
+    CDiskBlockPos pos(nFile, 0);
+    if (!WriteBlockToDisk(block, pos, Params().MessageStart()))
+        throw std::runtime_error("bench: WriteBlockToDisk failed");
+    return pos;
+}
+
+// Genesis block read back through the position, with its proof-of-work recomputed
+static void ReadBlockFromDiskPoW(benchmark::State& state)
+{
+    BenchDataDir datadir;
+    const CDiskBlockPos pos = WriteBenchBlock(Params().GenesisBlock(), 0);
+    const Consensus::Params& consensus = Params().GetConsensus();
+    CBlock block;
+    while (state.KeepRunning()) {
+        if (!ReadBlockFromDisk(block, pos, consensus))
+            throw std::runtime_error("bench: ReadBlockFromDisk failed");
+    }
+}
+
+// A block of BENCH_BLOCK_TXS transactions read through its index entry, I/O and deserialization only
+static void ReadBlockFromDiskIndex(benchmark::State& state)
+{
+    CBlock block = Params().GenesisBlock();
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    mtx.vout.resize(2);
+    mtx.vout[0].scriptPubKey = mtx.vout[1].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG;
+    for (int i = 0; i < BENCH_BLOCK_TXS; i++) {
+        mtx.vin[0].prevout = COutPoint(block.vtx.back()->GetHash(), i % 2);
+        block.vtx.push_back(MakeTransactionRef(mtx));
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+
+    BenchDataDir datadir;
+    const CDiskBlockPos pos = WriteBenchBlock(block, 1);
+    CBlockIndex index(block.GetBlockHeader());
+    uint256 hash = block.GetHash();
+    index.phashBlock = &hash;
+    index.nFile = pos.nFile;
+    index.nDataPos = pos.nPos;
+    index.nStatus = BLOCK_HAVE_DATA;
+
+    const Consensus::Params& consensus = Params().GetConsensus();
+    CBlock blockRead;
+    state.SetItemsPerIteration(block.vtx.size());
+    while (state.KeepRunning()) {
+        if (!ReadBlockFromDisk(blockRead, &index, consensus))
+            throw std::runtime_error("bench: ReadBlockFromDisk failed");
+    }
+}
+
+BENCHMARK(ReadBlockFromDiskPoW);
+BENCHMARK(ReadBlockFromDiskIndex);
@@ -2,8 +2,6 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#include <iostream>
-
 #include "bench.h"
 #include "bloom.h"
 #include "utiltime.h"
@@ -26,7 +24,8 @@ static void RollingBloom(benchmark::State& state)
             int64_t b = GetTimeMicros();
             filter.insert(data);
             int64_t e = GetTimeMicros();
-            std::cout << "RollingBloom-refresh,1," << (e-b)*0.000001 << "," << (e-b)*0.000001 << "," << (e-b)*0.000001 << "\n";
+            double elapsed = (e-b)*0.000001;
+            benchmark::BenchRunner::Report({"RollingBloom-refresh", 1, elapsed, elapsed, elapsed, 0});
             countnow = 0;
         } else {
             filter.insert(data);
@@ -45,12 +45,14 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint& outpoint) const
 {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        cacheCoins.touch(it);
         return it;
+    }
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
-    CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    CCoinsMap::iterator ret = cacheCoins.try_emplace(outpoint, std::move(tmp)).first;
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
@@ -77,7 +79,7 @@ void CCoinsViewCache::AddCoin(const COutPoint& outpoint, Coin&& coin, bool possi
         return;
     CCoinsMap::iterator it;
     bool inserted;
-    std::tie(it, inserted) = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::tuple<>());
+    std::tie(it, inserted) = cacheCoins.try_emplace(outpoint);
     bool fresh = false;
     if (!inserted) {
         cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
@@ -140,12 +142,28 @@ bool CCoinsViewCache::HaveCoin(const COutPoint& outpoint) const
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+bool CCoinsViewCache::HaveEntryInCache(const COutPoint& outpoint) const
+{
+    return cacheCoins.count(outpoint) > 0;
+}
+
 bool CCoinsViewCache::HaveCoinInCache(const COutPoint& outpoint) const
 {
     CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+bool CCoinsViewCache::CacheCoin(const COutPoint& outpoint, Coin&& coin)
+{
+    assert(!coin.IsSpent());
+    CCoinsMap::iterator it;
+    bool inserted;
+    std::tie(it, inserted) = cacheCoins.try_emplace(outpoint, std::move(coin));
+    if (inserted)
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    return inserted;
+}
+
 uint256 CCoinsViewCache::GetBestBlock() const
 {
     if (hashBlock.IsNull())
@@ -232,6 +250,38 @@ void CCoinsViewCache::Uncache(const COutPoint& hash)
     }
 }
 
+void CCoinsViewCache::SnapshotDirty(CCoinsMap& mapCoins)
+{
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end(); ++it) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY))
+            continue;
+        CCoinsCacheEntry& entry = mapCoins.try_emplace(it->first, Coin(it->second.coin)).first->second;
+        entry.flags = CCoinsCacheEntry::DIRTY;
+        // Spent entries stay as unmodified placeholders, so that lookups don't
+        // reach the base view before it has seen the spend.
+        it->second.flags = 0;
+    }
+}
+
+size_t CCoinsViewCache::EvictClean(size_t nTargetUsage)
+{
+    // Evicting only frees arena slots, so sweep until the remaining coins would
+    // fit and then compact the arena if what it holds is still too much.
+    const size_t nChunkUsage = memusage::MallocUsage(CCoinsMap::chunk_bytes());
+    size_t nEvicted = cacheCoins.sweep([this](const CCoinsMap::value_type& entry) {
+            if (entry.second.flags != 0)
+                return false;
+            cachedCoinsUsage -= entry.second.coin.DynamicMemoryUsage();
+            return true;
+        },
+        [this, nTargetUsage, nChunkUsage]() {
+            return nChunkUsage * cacheCoins.chunks_in_use() + memusage::MallocUsage(cacheCoins.index_bytes()) + cachedCoinsUsage <= nTargetUsage;
+        });
+    if (DynamicMemoryUsage() > nTargetUsage && cacheCoins.chunk_count() > cacheCoins.chunks_in_use())
+        cacheCoins.compact();
+    return nEvicted;
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const
 {
     return cacheCoins.size();
@@ -8,6 +8,7 @@
 #ifndef CASH_COINS_H
 #define CASH_COINS_H
 
+#include "arenamap.h"
 #include "compressor.h"
 #include "core_memusage.h"
 #include "hash.h"
@@ -19,7 +20,6 @@
 #include <stdint.h>
 
 #include <boost/foreach.hpp>
-#include <unordered_map>
 
 /**
  * A UTXO entry.
@@ -127,7 +127,8 @@ struct CCoinsCacheEntry {
     explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/** Flat map of cached coins; see arenamap for its iterator and reference guarantees. */
+typedef arenamap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -234,6 +235,19 @@ public:
      */
     bool HaveCoinInCache(const COutPoint& outpoint) const;
 
+    /**
+     * Check if this cache has an entry for the given outpoint, including one
+     * for a spent coin. No calls to the backing CCoinsView are made.
+     */
+    bool HaveEntryInCache(const COutPoint& outpoint) const;
+
+    /**
+     * Add a coin that was just read from the base view, unless the cache has an
+     * entry for the outpoint already. Used to warm the cache ahead of lookups.
+     * Returns whether the coin was added.
+     */
+    bool CacheCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Return a reference to Coin in the cache, or a pruned one if not found. This is
      * more efficient than GetCoin.
@@ -272,6 +286,21 @@ public:
      */
     void Uncache(const COutPoint& outpoint);
 
+    /**
+     * Copy all modified entries into mapCoins (to be passed to the base view's
+     * BatchWrite) and mark them unmodified, keeping them cached. Until that
+     * write has completed, the entries must not be evicted, as the base view
+     * may still return their previous state.
+     */
+    void SnapshotDirty(CCoinsMap& mapCoins);
+
+    /**
+     * Evict unmodified entries, least recently used first, until the cache uses
+     * at most nTargetUsage bytes, and release the memory they took. Returns the
+     * number of evicted entries.
+     */
+    size_t EvictClean(size_t nTargetUsage);
+
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
@@ -143,6 +143,7 @@ int argon2_hash(const uint32_t t_cost, const uint32_t m_cost,
     context.threads = parallelism;
     context.allocate_cbk = NULL;
     context.free_cbk = NULL;
+    context.parallel_cbk = NULL;
     context.flags = ARGON2_DEFAULT_FLAGS;
 
     result = argon2_ctx(&context, type);
@@ -165,6 +165,11 @@ typedef enum Argon2_ErrorCodes {
 typedef int (*allocate_fptr)(uint8_t** memory, size_t bytes_to_allocate);
 typedef void (*deallocate_fptr)(uint8_t* memory, size_t bytes_to_allocate);
 
+/* Job run for every index in [0, count) by a parallel_fptr */
+typedef void (*argon2_job_fptr)(void* arg, uint32_t index);
+/* Run job(arg, i) for every i in [0, count), returning once all have finished */
+typedef int (*parallel_fptr)(argon2_job_fptr job, void* arg, uint32_t count);
+
 /* Argon2 external data structures */
 
 /*
@@ -215,6 +220,7 @@ typedef struct Argon2_Context {
 
     allocate_fptr allocate_cbk; /* pointer to memory allocator */
     deallocate_fptr free_cbk;   /* pointer to memory deallocator */
+    parallel_fptr parallel_cbk; /* pointer to lane executor, NULL to spawn threads */
 
     uint32_t flags; /* array of bool options */
 } argon2_context;
@@ -234,6 +240,12 @@ typedef enum Argon2_type {
  */
 ARGON2_PUBLIC const char* argon2_type2string(argon2_type type, int uppercase);
 
+/*
+ * Select the fastest fill_segment kernel supported by the running CPU.
+ * @return Name of the selected kernel
+ */
+ARGON2_PUBLIC const char* argon2_select_impl(void);
+
 /*
  * Function that performs memory-hard hashing with certain degree of parallelism
  * @param  context  Pointer to the Argon2 internal structure
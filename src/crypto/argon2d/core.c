@@ -256,7 +256,7 @@ static int fill_memory_blocks_st(argon2_instance_t *instance) {
         for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
             for (l = 0; l < instance->lanes; ++l) {
                 argon2_position_t position = {r, l, (uint8_t)s, 0};
-                fill_segment(instance, position);
+                argon2_fill_segment(instance, position);
             }
         }
     }
@@ -272,7 +272,7 @@ static void *fill_segment_thr(void *thread_data)
 #endif
 {
     argon2_thread_data *my_data = thread_data;
-    fill_segment(my_data->instance_ptr, my_data->pos);
+    argon2_fill_segment(my_data->instance_ptr, my_data->pos);
     argon2_thread_exit();
     return 0;
 }
@@ -358,10 +358,45 @@ fail:
 
 #endif /* ARGON2_NO_THREADS */
 
+typedef struct Argon2_slice_job_t {
+    const argon2_instance_t *instance;
+    uint32_t pass;
+    uint8_t slice;
+} argon2_slice_job_t;
+
+static void fill_segment_job(void *arg, uint32_t lane) {
+    const argon2_slice_job_t *job = arg;
+    argon2_position_t position = {job->pass, lane, job->slice, 0};
+    argon2_fill_segment(job->instance, position);
+}
+
+/* Version for p > 1 that hands each slice's lanes to context->parallel_cbk */
+static int fill_memory_blocks_cb(argon2_instance_t *instance) {
+    parallel_fptr parallel_cbk = instance->context_ptr->parallel_cbk;
+    argon2_slice_job_t job;
+    uint32_t r, s;
+
+    job.instance = instance;
+    for (r = 0; r < instance->passes; ++r) {
+        for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
+            job.pass = r;
+            job.slice = (uint8_t)s;
+            if (parallel_cbk(fill_segment_job, &job, instance->lanes)) {
+                return ARGON2_THREAD_FAIL;
+            }
+        }
+    }
+    return ARGON2_OK;
+}
+
 int fill_memory_blocks(argon2_instance_t *instance) {
 	if (instance == NULL || instance->lanes == 0) {
 	    return ARGON2_INCORRECT_PARAMETER;
     }
+    if (instance->threads > 1 && instance->context_ptr != NULL &&
+        instance->context_ptr->parallel_cbk != NULL) {
+        return fill_memory_blocks_cb(instance);
+    }
 #if defined(ARGON2_NO_THREADS)
     return fill_memory_blocks_st(instance);
 #else
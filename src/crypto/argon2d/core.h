@@ -219,6 +219,14 @@ void finalize(const argon2_context *context, argon2_instance_t *instance);
 void fill_segment(const argon2_instance_t *instance,
                   argon2_position_t position);
 
+typedef void (*fill_segment_fptr)(const argon2_instance_t *instance,
+                                  argon2_position_t position);
+
+/*
+ * The fill_segment kernel in use, chosen by argon2_select_impl()
+ */
+extern fill_segment_fptr argon2_fill_segment;
+
 /*
  * Function that fills the entire memory t_cost times based on the first two
  * blocks in each lane
@@ -0,0 +1,80 @@
+/*
+ * Runtime selection of the fill_segment kernel.
+ *
+ * opt.c is compiled once with the baseline flags and, where the compiler
+ * supports it, again with -mavx2 and -mavx512f (opt_avx2.c, opt_avx512f.c).
+ * argon2_select_impl() picks the widest kernel the CPU and OS support; until
+ * it is called the baseline kernel is used.
+ */
+
+#include <stdint.h>
+
+#include "argon2.h"
+#include "core.h"
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#include <cpuid.h>
+#define ARGON2_HAVE_CPUID 1
+#endif
+
+#if defined(ENABLE_ARGON2D_AVX2) && !defined(BUILD_CASH_INTERNAL)
+void fill_segment_avx2(const argon2_instance_t *instance,
+                       argon2_position_t position);
+#endif
+#if defined(ENABLE_ARGON2D_AVX512F) && !defined(BUILD_CASH_INTERNAL)
+void fill_segment_avx512f(const argon2_instance_t *instance,
+                          argon2_position_t position);
+#endif
+
+fill_segment_fptr argon2_fill_segment = fill_segment;
+
+#if defined(ARGON2_HAVE_CPUID)
+/* Extended control register 0, i.e. which register states the OS saves */
+static uint64_t xgetbv0(void) {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return ((uint64_t)d << 32) | a;
+}
+#endif
+
+const char *argon2_select_impl(void) {
+    const char *name = "default";
+    argon2_fill_segment = fill_segment;
+#if defined(ARGON2_HAVE_CPUID)
+    {
+        uint32_t eax, ebx, ecx, edx;
+        int have_avx2 = 0, have_avx512f = 0;
+        uint64_t xcr0 = 0;
+
+        (void)have_avx2;
+        (void)have_avx512f;
+
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(1, 0, eax, ebx, ecx, edx);
+            /* OSXSAVE and AVX */
+            if (((ecx >> 27) & 1) && ((ecx >> 28) & 1)) {
+                xcr0 = xgetbv0();
+            }
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            /* YMM state enabled */
+            have_avx2 = ((ebx >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+            /* YMM, opmask and ZMM state enabled */
+            have_avx512f = ((ebx >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+        }
+
+#if defined(ENABLE_ARGON2D_AVX2) && !defined(BUILD_CASH_INTERNAL)
+        if (have_avx2) {
+            argon2_fill_segment = fill_segment_avx2;
+            name = "avx2";
+        }
+#endif
+#if defined(ENABLE_ARGON2D_AVX512F) && !defined(BUILD_CASH_INTERNAL)
+        if (have_avx512f) {
+            argon2_fill_segment = fill_segment_avx512f;
+            name = "avx512f";
+        }
+#endif
+    }
+#endif
+    return name;
+}
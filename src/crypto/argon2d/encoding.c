@@ -346,6 +346,7 @@ int decode_string(argon2_context *ctx, const char *str, argon2_type type) {
     ctx->adlen = 0;
     ctx->allocate_cbk = NULL;
     ctx->free_cbk = NULL;
+    ctx->parallel_cbk = NULL;
     ctx->flags = ARGON2_DEFAULT_FLAGS;
 
     /* On return, must have valid context */
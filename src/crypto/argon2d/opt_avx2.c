@@ -0,0 +1,9 @@
+/*
+ * AVX2 build of the optimized fill_segment kernel. Compiled with -mavx2 into
+ * a separate library and selected at runtime by argon2_select_impl().
+ */
+
+#if defined(ENABLE_ARGON2D_AVX2)
+#define fill_segment fill_segment_avx2
+#include "opt.c"
+#endif
@@ -0,0 +1,10 @@
+/*
+ * AVX-512F build of the optimized fill_segment kernel. Compiled with
+ * -mavx512f into a separate library and selected at runtime by
+ * argon2_select_impl().
+ */
+
+#if defined(ENABLE_ARGON2D_AVX512F)
+#define fill_segment fill_segment_avx512f
+#include "opt.c"
+#endif
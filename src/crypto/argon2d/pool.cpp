@@ -0,0 +1,108 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/argon2d/pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+#endif
+static const size_t PAGE_SIZE_MIN = 4096;
+
+/** Allocate a buffer of at least bytes, preferring transparent huge pages, and
+ *  touch every page so the hash loop never takes a page fault. */
+static uint8_t* AllocateArena(size_t& bytes)
+{
+    uint8_t* arena = NULL;
+#if defined(__linux__)
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED) {
+#if defined(MADV_HUGEPAGE)
+        madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        arena = static_cast<uint8_t*>(p);
+    }
+#else
+    arena = static_cast<uint8_t*>(malloc(bytes));
+#endif
+    if (arena) {
+        for (size_t i = 0; i < bytes; i += PAGE_SIZE_MIN)
+            arena[i] = 0;
+    }
+    return arena;
+}
+
+static void FreeArena(uint8_t* arena, size_t bytes)
+{
+#if defined(__linux__)
+    munmap(arena, bytes);
+#else
+    free(arena);
+#endif
+}
+
+class Argon2dArena
+{
+public:
+    uint8_t* memory;
+    size_t size;
+    bool fInUse;
+
+    Argon2dArena() : memory(NULL), size(0), fInUse(false) {}
+
+    ~Argon2dArena()
+    {
+        if (memory)
+            FreeArena(memory, size);
+    }
+
+    uint8_t* Acquire(size_t bytes)
+    {
+        if (fInUse)
+            return NULL;
+        if (size < bytes) {
+            if (memory)
+                FreeArena(memory, size);
+            size = bytes;
+            memory = AllocateArena(size);
+            if (!memory) {
+                size = 0;
+                return NULL;
+            }
+        }
+        fInUse = true;
+        return memory;
+    }
+};
+
+static thread_local Argon2dArena threadArena;
+
+} // namespace
+
+int Argon2dPoolAllocate(uint8_t** memory, size_t bytes_to_allocate)
+{
+    // Fall back to the heap if this thread's arena is already handed out
+    *memory = threadArena.Acquire(bytes_to_allocate);
+    if (*memory == NULL)
+        *memory = static_cast<uint8_t*>(malloc(bytes_to_allocate));
+    return *memory == NULL ? -1 : 0;
+}
+
+void Argon2dPoolFree(uint8_t* memory, size_t bytes_to_allocate)
+{
+    if (memory != NULL && memory == threadArena.memory) {
+        threadArena.fInUse = false;
+        return;
+    }
+    free(memory);
+}
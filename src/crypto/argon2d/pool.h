@@ -0,0 +1,22 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_CRYPTO_ARGON2D_POOL_H
+#define CASH_CRYPTO_ARGON2D_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Per-thread Argon2d working memory.
+ *
+ * Every Argon2d hash needs a 1-8 MiB block matrix. Instead of a malloc/free
+ * (and the resulting page faults) per hash, each thread keeps one pre-faulted,
+ * huge-page backed buffer that is reused by all hashes computed on it and
+ * released when the thread exits. The functions match the argon2_context
+ * allocate_cbk/free_cbk signatures.
+ */
+int Argon2dPoolAllocate(uint8_t** memory, size_t bytes_to_allocate);
+void Argon2dPoolFree(uint8_t* memory, size_t bytes_to_allocate);
+
+#endif // CASH_CRYPTO_ARGON2D_POOL_H
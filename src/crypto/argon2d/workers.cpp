@@ -0,0 +1,168 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/argon2d/workers.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/** Number of polls a worker spins for the next slice before sleeping */
+static const int WORKER_SPIN_COUNT = 20000;
+
+class Argon2dLaneWorkers
+{
+private:
+    std::mutex mutexJob;   //!< held by the hash currently using the workers
+    std::mutex mutexWake;
+    std::condition_variable condWake;
+    std::vector<std::thread> threads;
+
+    std::atomic<uint64_t> nGeneration;
+    std::atomic<bool> fStop;
+    std::atomic<uint32_t> nSize; //!< worker threads plus the calling thread
+
+    // Current job, published by bumping nGeneration
+    argon2_job_fptr job;
+    void* arg;
+    uint32_t nCount;
+    std::atomic<uint32_t> nNext;
+    std::atomic<uint32_t> nDone;
+    std::atomic<uint32_t> nExited; //!< workers finished with the current job
+
+    void RunJob()
+    {
+        uint32_t nIndex;
+        while ((nIndex = nNext.fetch_add(1)) < nCount) {
+            job(arg, nIndex);
+            nDone.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void WorkerThread(uint64_t nSeen)
+    {
+        while (true) {
+            int nSpin = 0;
+            while (nGeneration.load(std::memory_order_acquire) == nSeen && !fStop.load()) {
+                if (++nSpin < WORKER_SPIN_COUNT) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(mutexWake);
+                condWake.wait(lock, [&] { return nGeneration.load() != nSeen || fStop.load(); });
+            }
+            if (fStop.load())
+                return;
+            nSeen = nGeneration.load(std::memory_order_acquire);
+            RunJob();
+            nExited.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+public:
+    Argon2dLaneWorkers() : nGeneration(0), fStop(false), nSize(1), job(NULL), arg(NULL), nCount(0), nNext(0), nDone(0), nExited(0) {}
+
+    ~Argon2dLaneWorkers()
+    {
+        Stop();
+    }
+
+    void Start(int nThreads)
+    {
+        std::lock_guard<std::mutex> lockJob(mutexJob);
+        fStop = false;
+        for (int i = 0; i < nThreads - 1; i++)
+            threads.emplace_back(&Argon2dLaneWorkers::WorkerThread, this, nGeneration.load());
+        nSize = threads.size() + 1;
+    }
+
+    void Stop()
+    {
+        // Wait for a hash still using the workers
+        std::lock_guard<std::mutex> lockJob(mutexJob);
+        nSize = 1;
+        {
+            std::lock_guard<std::mutex> lock(mutexWake);
+            fStop = true;
+        }
+        condWake.notify_all();
+        for (std::thread& thread : threads)
+            thread.join();
+        threads.clear();
+    }
+
+    uint32_t Size() const
+    {
+        return nSize.load();
+    }
+
+    bool Run(argon2_job_fptr jobIn, void* argIn, uint32_t nCountIn)
+    {
+        std::unique_lock<std::mutex> lockJob(mutexJob, std::try_to_lock);
+        if (!lockJob.owns_lock() || threads.empty())
+            return false;
+
+        job = jobIn;
+        arg = argIn;
+        nCount = nCountIn;
+        nDone = 0;
+        nNext = 0;
+        nExited = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutexWake);
+            nGeneration.fetch_add(1, std::memory_order_release);
+        }
+        condWake.notify_all();
+
+        // The caller works on the slice too, then waits until every worker is
+        // done with it so none can still be reading the job when it changes
+        RunJob();
+        while (nDone.load(std::memory_order_acquire) < nCount ||
+               nExited.load(std::memory_order_acquire) < threads.size())
+            std::this_thread::yield();
+        return true;
+    }
+};
+
+static Argon2dLaneWorkers laneWorkers;
+static thread_local bool fThreadParallel = true;
+
+} // namespace
+
+void Argon2dStartLaneWorkers(int nThreads)
+{
+    Argon2dStopLaneWorkers();
+    if (nThreads > MAX_ARGON2D_THREADS)
+        nThreads = MAX_ARGON2D_THREADS;
+    if (nThreads > 1)
+        laneWorkers.Start(nThreads);
+}
+
+void Argon2dStopLaneWorkers()
+{
+    laneWorkers.Stop();
+}
+
+uint32_t Argon2dLaneThreads()
+{
+    return fThreadParallel ? laneWorkers.Size() : 1;
+}
+
+void Argon2dSetThreadParallel(bool fParallel)
+{
+    fThreadParallel = fParallel;
+}
+
+int Argon2dParallelLanes(argon2_job_fptr job, void* arg, uint32_t count)
+{
+    if (!laneWorkers.Run(job, arg, count)) {
+        for (uint32_t i = 0; i < count; i++)
+            job(arg, i);
+    }
+    return 0;
+}
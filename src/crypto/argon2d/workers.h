@@ -0,0 +1,37 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_CRYPTO_ARGON2D_WORKERS_H
+#define CASH_CRYPTO_ARGON2D_WORKERS_H
+
+#include "crypto/argon2d/argon2.h"
+
+#include <stdint.h>
+
+/** Default for -argon2dthreads, 0 = one per core up to MAX_ARGON2D_THREADS */
+static const int DEFAULT_ARGON2D_THREADS = 0;
+/** Maximum number of threads filling the lanes of a single Argon2d hash */
+static const int MAX_ARGON2D_THREADS = 8;
+
+/** Persistent workers that fill the lanes of a single Argon2d hash in parallel.
+ *
+ * Each slice of an Argon2d pass can fill its lanes independently, so a header
+ * hash can be spread across a few cores to cut the latency of verifying one
+ * block. The workers are started once and shared by all hashing threads; a
+ * hash that finds them busy (or a thread that opted out) runs serially.
+ */
+void Argon2dStartLaneWorkers(int nThreads);
+void Argon2dStopLaneWorkers();
+
+/** Number of threads (including the caller) a hash on this thread may use, 1 if serial */
+uint32_t Argon2dLaneThreads();
+
+/** Opt the calling thread in or out of parallel lane filling. Miner threads
+ *  already keep every core busy and hash serially. */
+void Argon2dSetThreadParallel(bool fParallel);
+
+/** argon2_context parallel_cbk running the lanes on the workers */
+int Argon2dParallelLanes(argon2_job_fptr job, void* arg, uint32_t count);
+
+#endif // CASH_CRYPTO_ARGON2D_WORKERS_H
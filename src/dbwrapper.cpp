@@ -11,6 +11,7 @@
 #include "util.h"
 
 #include <algorithm>
+#include <mutex>
 #include <memenv.h>
 #include <stdint.h>
 
@@ -77,14 +78,102 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static const CDBProfile dbProfiles[] = {
+    // name          open files                         bloom  cache  write buffer
+    {"default",      64,                                10,    50,    25},
+    // Coins are looked up at random all over the key space: keep table files open.
+    // On 64-bit systems LevelDB mmaps up to 1000 tables and closes their descriptors.
+    {"chainstate",   sizeof(void*) >= 8 ? 1000 : 64,    10,    50,    25},
+    // BDAP and fluid records are written once and rarely read back.
+    {"append",       64,                                10,    25,    25},
+};
+
+/** Directory names of the databases that use another profile than "default" */
+static const std::pair<const char*, const char*> dbDefaultProfiles[] = {
+    {"chainstate", "chainstate"},
+    {"bdap-entries", "append"},
+    {"bdap-certificates", "append"},
+    {"bdap-audits", "append"},
+    {"links", "append"},
+    {"fluid-mint", "append"},
+    {"fluid-mining", "append"},
+    {"fluid-masternode", "append"},
+    {"fluid-sovereign", "append"},
+    {"banned-accounts", "append"},
+};
+
+const CDBProfile* FindDBProfile(const std::string& strProfile)
+{
+    for (const CDBProfile& profile : dbProfiles) {
+        if (strProfile == profile.name)
+            return &profile;
+    }
+    return NULL;
+}
+
+bool ParseDBProfileArg(const std::string& strArg, std::string& strDatabaseOut, const CDBProfile*& profileOut)
+{
+    size_t nSep = strArg.rfind(':');
+    if (nSep == std::string::npos || nSep == 0)
+        return false;
+    strDatabaseOut = strArg.substr(0, nSep);
+    profileOut = FindDBProfile(strArg.substr(nSep + 1));
+    return profileOut != NULL;
+}
+
+const CDBProfile& GetDBProfile(const std::string& strDatabase)
+{
+    const CDBProfile* result = &dbProfiles[0];
+    for (const auto& item : dbDefaultProfiles) {
+        if (strDatabase == item.first)
+            result = FindDBProfile(item.second);
+    }
+    if (mapMultiArgs.count("-dbprofile")) {
+        for (const std::string& strArg : mapMultiArgs.at("-dbprofile")) {
+            std::string strArgDatabase;
+            const CDBProfile* profile;
+            if (ParseDBProfileArg(strArg, strArgDatabase, profile) && strArgDatabase == strDatabase)
+                result = profile;
+        }
+    }
+    return *result;
+}
+
+static std::mutex csSharedBlockCache;
+static std::shared_ptr<leveldb::Cache> sharedBlockCache;
+
+void SetSharedDBCacheSize(size_t nSize)
+{
+    std::lock_guard<std::mutex> lock(csSharedBlockCache);
+    // Databases that are still open keep the cache they were opened with.
+    sharedBlockCache.reset(nSize ? leveldb::NewLRUCache(nSize) : NULL);
+}
+
+size_t GetSharedDBCacheUsage()
+{
+    std::lock_guard<std::mutex> lock(csSharedBlockCache);
+    return sharedBlockCache ? sharedBlockCache->TotalCharge() : 0;
+}
+
+static std::shared_ptr<leveldb::Cache> GetBlockCache(size_t nCacheSize, const CDBProfile& profile)
+{
+    std::lock_guard<std::mutex> lock(csSharedBlockCache);
+    if (sharedBlockCache)
+        return sharedBlockCache;
+    return std::shared_ptr<leveldb::Cache>(leveldb::NewLRUCache(nCacheSize * profile.nBlockCachePercent / 100));
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const CDBProfile& profile, leveldb::Cache* blockCache)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.block_cache = blockCache;
+    options.write_buffer_size = nCacheSize * profile.nWriteBufferPercent / 100; // up to two write buffers may be held in memory simultaneously
+    if (profile.nBloomBits > 0)
+        options.filter_policy = leveldb::NewBloomFilterPolicy(profile.nBloomBits);
+    // LevelDB is built without Snappy here, and tables written compressed could
+    // not be read back by a build without it.
     options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.max_open_files = profile.nMaxOpenFiles;
     options.info_log = new CCashLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -101,7 +190,9 @@ CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, b
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    const CDBProfile& profile = GetDBProfile(path.filename().string());
+    blockCache = GetBlockCache(nCacheSize, profile);
+    options = GetOptions(nCacheSize, profile, blockCache.get());
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -113,7 +204,7 @@ CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, b
             dbwrapper_private::HandleError(result);
         }
         TryCreateDirectory(path);
-        LogPrintf("Opening LevelDB in %s\n", path.string());
+        LogPrintf("Opening LevelDB in %s (profile %s)\n", path.string(), profile.name);
     }
     leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
     dbwrapper_private::HandleError(status);
@@ -153,14 +244,15 @@ CDBWrapper::~CDBWrapper()
     options.filter_policy = NULL;
     delete options.info_log;
     options.info_log = NULL;
-    delete options.block_cache;
     options.block_cache = NULL;
+    blockCache.reset();
     delete penv;
     options.env = NULL;
 }
 
 bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
+    TRACE_SCOPE("leveldb", "WriteBatch");
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     dbwrapper_private::HandleError(status);
     return true;
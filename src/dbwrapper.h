@@ -11,10 +11,13 @@
 #include "clientversion.h"
 #include "serialize.h"
 #include "streams.h"
+#include "trace.h"
 #include "util.h"
 #include "utilstrencodings.h"
 #include "version.h"
 
+#include <memory>
+
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
@@ -31,6 +34,39 @@ public:
 
 class CDBWrapper;
 
+/** LevelDB settings shared by databases with a similar access pattern */
+struct CDBProfile {
+    const char* name;
+    int nMaxOpenFiles;       //!< number of table files LevelDB keeps open
+    int nBloomBits;          //!< bloom filter bits per key, 0 to disable the filter
+    int nBlockCachePercent;  //!< share of the database's cache size given to the block cache, unless a shared one is set
+    int nWriteBufferPercent; //!< share of the database's cache size given to each of the (up to two) write buffers
+};
+
+/** Look up a profile by name, returns NULL if there is none */
+const CDBProfile* FindDBProfile(const std::string& strProfile);
+
+/** Parse a -dbprofile=<database>:<profile> argument */
+bool ParseDBProfileArg(const std::string& strArg, std::string& strDatabaseOut, const CDBProfile*& profileOut);
+
+/**
+ * Profile to open a database with, by the name of its directory. -dbprofile
+ * overrides the built-in choice: the chainstate gets a large table file budget,
+ * the append-mostly BDAP and fluid databases a smaller block cache.
+ */
+const CDBProfile& GetDBProfile(const std::string& strDatabase);
+
+/**
+ * Let all databases opened from now on share one LevelDB block cache of nSize
+ * bytes instead of each using a share of its own cache size. Blocks of all
+ * databases compete in the same LRU, so the memory goes to the databases that
+ * are read the most. 0 switches back to a block cache per database.
+ */
+void SetSharedDBCacheSize(size_t nSize);
+
+/** Bytes held by the shared block cache */
+size_t GetSharedDBCacheUsage();
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private
@@ -189,6 +225,9 @@ private:
     //! database options used
     leveldb::Options options;
 
+    //! block cache, possibly shared with other databases
+    std::shared_ptr<leveldb::Cache> blockCache;
+
     //! options used when reading from the database
     leveldb::ReadOptions readoptions;
 
@@ -218,7 +257,8 @@ private:
 public:
     /**
      * @param[in] path        Location in the filesystem where leveldb data will be stored.
-     * @param[in] nCacheSize  Configures various leveldb cache settings.
+     * @param[in] nCacheSize  Configures various leveldb cache settings, split as chosen by the
+     *                        database's profile (see GetDBProfile).
      * @param[in] fMemory     If true, use leveldb's memory environment.
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
@@ -230,6 +270,7 @@ public:
     template <typename K, typename V>
     bool Read(const K& key, V& value) const
     {
+        TRACE_SCOPE("leveldb", "Read");
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
@@ -290,6 +331,7 @@ public:
     template <typename K>
     bool Exists(const K& key) const
     {
+        TRACE_SCOPE("leveldb", "Exists");
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
@@ -19,6 +19,7 @@
 #include "net.h"
 #include "spork.h"
 #include "util.h"
+#include "trace.h"
 #include "utiltime.h" // for GetTimeMillis
 #include "validation.h"
 
@@ -569,6 +570,7 @@ uint32_t GetLastPutDate(const HashRecordKey& recordKey)
 
 bool CHashTableSession::SubmitPut(const std::array<char, 32> public_key, const std::array<char, 64> private_key, const int64_t lastSequence, const std::string& strSalt, const libtorrent::entry& entryValue)
 {
+    TRACE_SCOPE("dht", "SubmitPut");
     Session->dht_put_item(public_key, std::bind(&DHT::put_mutable_bytes, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, 
                           public_key, private_key, entryValue, lastSequence), strSalt);
     return true;
@@ -576,6 +578,7 @@ bool CHashTableSession::SubmitPut(const std::array<char, 32> public_key, const s
 
 bool CHashTableSession::SubmitGet(const std::array<char, 32>& public_key, const std::string& recordSalt)
 {
+    TRACE_SCOPE("dht", "SubmitGet");
     if (!Session) {
         LogPrintf("CHashTableSession::%s -- Session null.  Submit get failed.\n", __func__);
         return false;
@@ -734,6 +737,7 @@ bool CHashTableSession::GetDataFromMap(const std::array<char, 32>& public_key, c
 
 bool CHashTableSession::SubmitGetAllRecordsSync(const std::vector<CLinkInfo>& vchLinkInfo, const std::string& strOperationType, std::vector<CDataRecord>& vchRecords)
 {
+    TRACE_SCOPE_ARG("dht", "SubmitGetAllRecordsSync", strOperationType);
     std::vector<std::pair<CLinkInfo, std::string>> headerValues;
     for (const CLinkInfo& linkInfo : vchLinkInfo) {
         int64_t iSequence;
@@ -759,6 +763,7 @@ static std::array<char, 32> EncodedVectorCharToArray32(const std::vector<unsigne
 
 bool CHashTableSession::SubmitGetAllRecordsAsync(const std::vector<CLinkInfo>& vchLinkInfo, const std::string& strOperationType, std::vector<CDataRecord>& vchRecords)
 {
+    TRACE_SCOPE_ARG("dht", "SubmitGetAllRecordsAsync", strOperationType);
     uint16_t nTotalSlots = GetMaximumSlots(strOperationType);
     strErrorMessage = "";
     // Get the headers first
@@ -9,6 +9,8 @@
 #define CASH_HASH_H
 
 #include "crypto/argon2d/argon2.h"
+#include "crypto/argon2d/pool.h"
+#include "crypto/argon2d/workers.h"
 #include "crypto/blake2/blake2.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha256.h"
@@ -328,7 +330,7 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
 /// Associated data length: 0
 /// Memory cost: 2048 kibibytes
 /// Lanes: 12 parallel threads
-/// Threads: 1 threads
+/// Threads: 1 thread, or the Argon2d lane workers (-argon2dthreads) when verifying
 /// Time Constraint: 3 iterations
 inline int Argon2d_Phase0_Hash(const void* in, const size_t size, const void* out)
 {
@@ -343,13 +345,14 @@ inline int Argon2d_Phase0_Hash(const void* in, const size_t size, const void* ou
     context.secretlen = 0;
     context.ad = NULL;
     context.adlen = 0;
-    context.allocate_cbk = NULL;
-    context.free_cbk = NULL;
+    context.allocate_cbk = Argon2dPoolAllocate;
+    context.free_cbk = Argon2dPoolFree;
+    context.parallel_cbk = Argon2dParallelLanes;
     context.flags = DEFAULT_ARGON2_FLAG; // = ARGON2_DEFAULT_FLAGS
     // main configurable Argon2 hash parameters
     context.m_cost = 2048; // Memory in KiB (2 MiB)
     context.lanes = 12;    // Degree of Parallelism
-    context.threads = 1;   // Threads
+    context.threads = Argon2dLaneThreads(); // Threads
     context.t_cost = 3;    // Iterations
 
     return argon2_ctx(&context, Argon2_d);
@@ -368,7 +371,7 @@ inline int Argon2d_Phase0_Hash(const void* in, const size_t size, const void* ou
 /// Associated data length: 0
 /// Memory cost: 1000 kibibytes
 /// Lanes: 8 parallel threads
-/// Threads: 1 threads
+/// Threads: 1 thread, or the Argon2d lane workers (-argon2dthreads) when verifying
 /// Time Constraint: 2 iterations
 inline int Argon2d_Phase1_Hash(const void* in, const size_t size, const void* out)
 {
@@ -383,13 +386,14 @@ inline int Argon2d_Phase1_Hash(const void* in, const size_t size, const void* ou
     context.secretlen = 0;
     context.ad = NULL;
     context.adlen = 0;
-    context.allocate_cbk = NULL;
-    context.free_cbk = NULL;
+    context.allocate_cbk = Argon2dPoolAllocate;
+    context.free_cbk = Argon2dPoolFree;
+    context.parallel_cbk = Argon2dParallelLanes;
     context.flags = DEFAULT_ARGON2_FLAG; // = ARGON2_DEFAULT_FLAGS
     // main configurable Argon2 hash parameters
     context.m_cost = 1000; // Memory in KiB (1000 KiB)
     context.lanes = 8;     // Degree of Parallelism
-    context.threads = 1;   // Threads
+    context.threads = Argon2dLaneThreads(); // Threads
     context.t_cost = 2;    // Iterations
 
     return argon2_ctx(&context, Argon2_d);
@@ -408,7 +412,7 @@ inline int Argon2d_Phase1_Hash(const void* in, const size_t size, const void* ou
 /// Associated data length: 0
 /// Memory cost: 8192 kibibytes
 /// Lanes: 64 parallel threads
-/// Threads: 1 threads
+/// Threads: 1 thread, or the Argon2d lane workers (-argon2dthreads) when verifying
 /// Time Constraint: 16 iterations
 inline int Argon2d_Phase2_Hash(const void* in, const size_t size, const void* out)
 {
@@ -423,18 +427,29 @@ inline int Argon2d_Phase2_Hash(const void* in, const size_t size, const void* ou
     context.secretlen = 0;
     context.ad = NULL;
     context.adlen = 0;
-    context.allocate_cbk = NULL;
-    context.free_cbk = NULL;
+    context.allocate_cbk = Argon2dPoolAllocate;
+    context.free_cbk = Argon2dPoolFree;
+    context.parallel_cbk = Argon2dParallelLanes;
     context.flags = DEFAULT_ARGON2_FLAG; // = ARGON2_DEFAULT_FLAGS
     // main configurable Argon2 hash parameters
     context.m_cost = 8192; // Memory in KiB (8 MiB)
     context.lanes = 64;    // Degree of Parallelism
-    context.threads = 1;   // Threads
+    context.threads = Argon2dLaneThreads(); // Threads
     context.t_cost = 16;    // Iterations
 
     return argon2_ctx(&context, Argon2_d);
 }
 
+/// Memory cost in kibibytes of the Argon2d phase, as set by Argon2d_Phase*_Hash
+inline uint32_t Argon2d_MemoryCost(const unsigned int& hashPhase)
+{
+    if (hashPhase == 1)
+        return 1000;
+    if (hashPhase == 2)
+        return 8192;
+    return 2048;
+}
+
 template <typename T1>
 inline uint256 hash_Argon2d(const T1 pbegin, const T1 pend, const unsigned int& hashPhase)
 {
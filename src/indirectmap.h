@@ -8,6 +8,8 @@
 #ifndef CASH_INDIRECTMAP_H
 #define CASH_INDIRECTMAP_H
 
+#include <map>
+
 template <class T>
 struct DereferencingComparator {
     bool operator()(const T a, const T b) const { return *a < *b; }
@@ -21,6 +21,7 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
+#include "crypto/argon2d/workers.h"
 #include "bdap/domainentrydb.h"
 #include "bdap/linkingdb.h"
 #include "bdap/linkmanager.h"
@@ -41,8 +42,11 @@
 #include "instantsend.h"
 #include "key.h"
 #include "messagesigner.h"
+#include "miner/internal/cpu-placement.h"
+#include "miner/internal/miner-context.h"
 #include "miner/internal/miners-controller.h"
 #include "miner/miner.h"
+#include "miner/stratum.h"
 #include "net.h"
 #include "net_processing.h"
 #include "netfulfilledman.h"
@@ -63,6 +67,7 @@
 #include "spork.h"
 #include "timedata.h"
 #include "torcontrol.h"
+#include "trace.h"
 #include "txdb.h"
 #include "txmempool.h"
 #include "ui_interface.h"
@@ -233,6 +238,7 @@ void Interrupt(boost::thread_group& threadGroup)
     InterruptRPC();
     InterruptREST();
     InterruptTorControl();
+    InterruptStratumServer();
     if (g_connman)
         g_connman->Interrupt();
     threadGroup.interrupt_all();
@@ -304,6 +310,7 @@ void PrepareShutdown()
     if (pwalletMain)
         pwalletMain->Flush(false);
 #endif
+    StopStratumServer();
     ShutdownMiners();
     MapPort(false);
     UnregisterValidationInterface(peerLogic.get());
@@ -424,6 +431,7 @@ void Shutdown()
     }
     // Shutdown part 2: Stop TOR thread and delete wallet instance
     StopTorControl();
+    Argon2dStopLaneWorkers();
 #ifdef ENABLE_WALLET
     delete pwalletMain;
     pwalletMain = NULL;
@@ -433,6 +441,7 @@ void Shutdown()
     ECC_Stop_Stealth();
     ECC_Ed25519_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopDebugLogWriter();
 }
 
 /**
@@ -494,6 +503,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt("-argon2dthreads=<n>", strprintf(_("Set the number of threads verifying a single Argon2d header hash (%u to %d, 0 = auto, <0 = leave that many cores free, 1 = no worker threads, default: %d)"),
+                                               -GetNumCores(), MAX_ARGON2D_THREADS, DEFAULT_ARGON2D_THREADS));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
@@ -507,13 +518,17 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-dbprofile=<db>:<profile>", _("Open the database in directory <db> (e.g. chainstate, index, bdap-entries, fluid-mint, dht) with LevelDB settings <profile>: default, chainstate (keeps more table files open) or append (smaller block cache). Can be specified multiple times"));
     strUsage += HelpMessageOpt("-feefilter", strprintf(_("Tell other nodes to filter invs to us by our mempool min fee (default: %u)"), DEFAULT_FEEFILTER));
+    strUsage += HelpMessageOpt("-incrementalflush", strprintf(_("Once synced, write the chain state from a background thread and only evict the least recently used coins from the cache (default: %u)"), DEFAULT_INCREMENTAL_FLUSH));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
                                                -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
+    if (showDebug)
+        strUsage += HelpMessageOpt("-scriptcheckdepth=<n>", strprintf("During initial block download, let script verification run behind block connection by up to <n> blocks (0 or 1 to disable, default: %d)", DEFAULT_SCRIPT_CHECK_DEPTH));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), CASH_PID_FILENAME));
 #endif
@@ -622,9 +637,11 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
         strUsage += HelpMessageOpt("-nodebug", "Turn off debugging messages, same as -debug=0");
     strUsage += HelpMessageOpt("-help-debug", _("Show all debugging options (usage: --help -help-debug)"));
+    strUsage += HelpMessageOpt("-logasync", strprintf(_("Write debug.log from a background thread instead of the logging threads. The last lines before a crash may be lost (default: %u)"), DEFAULT_LOGASYNC));
     strUsage += HelpMessageOpt("-logips", strprintf(_("Include IP addresses in debug output (default: %u)"), DEFAULT_LOGIPS));
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"), DEFAULT_LOGTIMESTAMPS));
     if (showDebug) {
+        strUsage += HelpMessageOpt("-logbuffer=<n>", strprintf("Number of debug messages queued per thread with -logasync before logging blocks and then drops messages (default: %u)", DEFAULT_LOGBUFFER));
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-logthreadnames", strprintf("Add thread names to debug messages (default: %u)", DEFAULT_LOGTHREADNAMES));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
@@ -643,6 +660,11 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-printpriority", strprintf("Log transaction priority and fee per kB when mining blocks (default: %u)", DEFAULT_PRINTPRIORITY));
     }
     strUsage += HelpMessageOpt("-shrinkdebugfile", _("Shrink debug.log file on client startup (default: 1 when no -debug)"));
+    strUsage += HelpMessageOpt("-trace", strprintf(_("Record timings of validation, network, database and hashing hot paths, see the dumptrace RPC (default: %u)"), DEFAULT_TRACE));
+    if (showDebug) {
+        strUsage += HelpMessageOpt("-tracebuffer=<n>", strprintf("Number of trace events kept per thread (default: %u)", DEFAULT_TRACE_BUFFER));
+        strUsage += HelpMessageOpt("-lockprofile", strprintf("Record wait and hold times of every lock site, see the getlockstats RPC. Requires a build configured with --enable-lockprofile (default: %u)", DEFAULT_LOCKPROFILE));
+    }
     AppendParamsHelpMessages(strUsage, showDebug);
     strUsage += HelpMessageOpt("-litemode=<n>", strprintf(_("Disable all Cash specific functionality (Masternodes, PrivateSend, InstantSend, Governance) (0-1, default: %u)"), 0));
     strUsage += HelpMessageOpt("-sporkaddr=<hex>", strprintf(_("Override spork address. Only useful for regtest and devnet. Using this on mainnet or testnet will ban you.")));
@@ -687,6 +709,16 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-blockmintxfee=<amt>", strprintf(_("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)"), CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)));
     if (showDebug)
         strUsage += HelpMessageOpt("-blockversion=<n>", "Override block version to test forking scenarios");
+    strUsage += HelpMessageOpt("-minertxdebounce=<ms>", strprintf(_("Coalesce miner block template rebuilds triggered by new transactions over this many milliseconds (default: %d)"), DEFAULT_MINER_TX_DEBOUNCE));
+    strUsage += HelpMessageOpt("-minerpinthreads", strprintf(_("Pin CPU miner threads to separate physical cores, using SMT siblings only when the Argon2d memory fits their cache (default: %u)"), DEFAULT_MINER_PIN_THREADS));
+
+    strUsage += HelpMessageGroup(_("Stratum server options:"));
+    strUsage += HelpMessageOpt("-stratum", strprintf(_("Accept Stratum v1 connections from external miners (default: %u)"), DEFAULT_STRATUM));
+    strUsage += HelpMessageOpt("-stratumbind=<addr>", strprintf(_("Bind to given address to listen for Stratum connections (default: %s)"), DEFAULT_STRATUM_BIND));
+    strUsage += HelpMessageOpt("-stratumport=<port>", strprintf(_("Listen for Stratum connections on <port> (default: %u)"), DEFAULT_STRATUM_PORT));
+    strUsage += HelpMessageOpt("-stratumallowip=<ip>", _("Allow Stratum connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times. Workers are not authenticated, any worker name is accepted from an allowed source (default: localhost only)"));
+    strUsage += HelpMessageOpt("-stratumaddress=<addr>", _("Pay blocks found by Stratum workers to <addr> (default: an address from the wallet)"));
+    strUsage += HelpMessageOpt("-stratumdifficulty=<n>", strprintf(_("Initial share difficulty of Stratum workers, relative to the proof-of-work limit (default: %s)"), DEFAULT_STRATUM_DIFFICULTY));
 
     strUsage += HelpMessageGroup(_("RPC server options:"));
     strUsage += HelpMessageOpt("-server", _("Accept command line and JSON-RPC commands"));
@@ -1042,9 +1074,13 @@ void InitLogging()
     fLogTimeMicros = GetBoolArg("-logtimemicros", DEFAULT_LOGTIMEMICROS);
     fLogThreadNames = GetBoolArg("-logthreadnames", DEFAULT_LOGTHREADNAMES);
     fLogIPs = GetBoolArg("-logips", DEFAULT_LOGIPS);
+    TraceInit(GetBoolArg("-trace", DEFAULT_TRACE), std::max<int64_t>(1, GetArg("-tracebuffer", DEFAULT_TRACE_BUFFER)));
 
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
     LogPrintf("Cash version %s\n", FormatFullVersion());
+
+    if (GetBoolArg("-lockprofile", DEFAULT_LOCKPROFILE) && !SetLockProfileEnabled(true))
+        LogPrintf("Warning: -lockprofile ignored, this build was not configured with --enable-lockprofile\n");
 }
 
 namespace
@@ -1186,6 +1222,7 @@ bool AppInitParameterInteraction()
         if (GetBoolArg("-nodebug", false) || find(categories.begin(), categories.end(), std::string("0")) != categories.end())
             fDebug = false;
     }
+    UpdateLogCategories();
 
     // Check for -debugnet
     if (GetBoolArg("-debugnet", false))
@@ -1213,6 +1250,15 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fIncrementalFlush = GetBoolArg("-incrementalflush", DEFAULT_INCREMENTAL_FLUSH);
+    if (mapMultiArgs.count("-dbprofile")) {
+        for (const std::string& strArg : mapMultiArgs.at("-dbprofile")) {
+            std::string strDatabase;
+            const CDBProfile* profile;
+            if (!ParseDBProfileArg(strArg, strDatabase, profile))
+                return InitError(strprintf(_("Invalid -dbprofile value: '%s'"), strArg));
+        }
+    }
 
     hashAssumeValid = uint256S(GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1242,6 +1288,7 @@ bool AppInitParameterInteraction()
         nScriptCheckThreads = 0;
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
+    nScriptCheckDepth = std::max(0, std::min((int)GetArg("-scriptcheckdepth", DEFAULT_SCRIPT_CHECK_DEPTH), MAX_SCRIPT_CHECK_DEPTH));
 
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = GetArg("-prune", 0);
@@ -1437,8 +1484,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         ShrinkDebugFile();
     }
 
-    if (fPrintToDebugLog)
+    if (fPrintToDebugLog) {
         OpenDebugLog();
+        if (GetBoolArg("-logasync", DEFAULT_LOGASYNC))
+            StartDebugLogWriter(std::max<int64_t>(2, GetArg("-logbuffer", DEFAULT_LOGBUFFER)));
+    }
 
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
@@ -1453,10 +1503,23 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     InitSignatureCache();
 
+    LogPrintf("Using the '%s' Argon2d implementation\n", argon2_select_impl());
+
+    // -argon2dthreads=0 means autodetect, a single thread means no lane workers
+    int nArgon2dThreads = GetArg("-argon2dthreads", DEFAULT_ARGON2D_THREADS);
+    if (nArgon2dThreads <= 0)
+        nArgon2dThreads += GetNumCores();
+    nArgon2dThreads = std::max(1, std::min(nArgon2dThreads, MAX_ARGON2D_THREADS));
+    LogPrintf("Using %d threads for Argon2d header verification\n", nArgon2dThreads);
+    Argon2dStartLaneWorkers(nArgon2dThreads);
+
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        for (int i = 0; i < nScriptCheckThreads - 1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadHeaderCheck);
+            threadGroup.create_thread(&ThreadCoinPrefetch);
+        }
     }
 
     std::vector<std::string> vSporkAddresses;
@@ -1711,6 +1774,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    // The block caches of all databases come out of one pool, which gets the memory the
+    // block index and chain state databases would have used for theirs.
+    int64_t nSharedDBCache = nBlockTreeDBCache / 2 + nCoinDBCache / 2;
+    SetSharedDBCacheSize(nSharedDBCache);
+    LogPrintf("* Using %.1fMiB for the block cache shared by all databases\n", nSharedDBCache * (1.0 / 1024 / 1024));
 
     int64_t nStart = GetTimeMillis();
     while (!fLoaded && !fRequestShutdown) {
@@ -1749,19 +1817,19 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
                 bool obfuscate = false;
                 // Init Fluid transaction DB's
-                pFluidMasternodeDB = new CFluidMasternodeDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pFluidMiningDB = new CFluidMiningDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pFluidMintDB = new CFluidMintDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pFluidSovereignDB = new CFluidSovereignDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pBanAccountDB = new CBanAccountDB(nTotalCache * 35, false, fReindex, obfuscate);
+                pFluidMasternodeDB = new CFluidMasternodeDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pFluidMiningDB = new CFluidMiningDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pFluidMintDB = new CFluidMintDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pFluidSovereignDB = new CFluidSovereignDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pBanAccountDB = new CBanAccountDB(nAuxDBCache << 20, false, fReindex, obfuscate);
                 // Init BDAP Services DBs
-                pDomainEntryDB = new CDomainEntryDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pAuditDB = new CAuditDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pCertificateDB = new CCertificateDB(nTotalCache * 35, false, fReindex, obfuscate);
-                pLinkDB = new CLinkDB(nTotalCache * 35, false, fReindex, obfuscate);
+                pDomainEntryDB = new CDomainEntryDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pAuditDB = new CAuditDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pCertificateDB = new CCertificateDB(nAuxDBCache << 20, false, fReindex, obfuscate);
+                pLinkDB = new CLinkDB(nAuxDBCache << 20, false, fReindex, obfuscate);
                 pLinkManager = new CLinkManager();
                 // Init DHT Services DB
-                //pMutableDataDB = new CMutableDataDB(nTotalCache * 35, false, fReindex, obfuscate);
+                //pMutableDataDB = new CMutableDataDB(nAuxDBCache << 20, false, fReindex, obfuscate);
 
                 if (fReindex) {
                     pblocktree->WriteReindexing(true);
@@ -2130,6 +2198,12 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         SetGPUMinerThreads(GetArg("-genproclimit-gpu", DEFAULT_GENERATE_THREADS_GPU));
         StartMiners();
     }
+    // Miners can also be started later over RPC, always keep their stats sampled
+    scheduler.scheduleEvery(SampleMinerStats, HASH_RATE_SAMPLE_INTERVAL);
+
+    // Serve external miners
+    if (GetBoolArg("-stratum", DEFAULT_STRATUM) && !StartStratumServer(chainparams, connman))
+        return InitError(_("Unable to start Stratum server. See debug log for details."));
 
     // Start the DHT Torrent networks in the background
     //const bool fMultiSessions = GetArg("-multidhtsessions", false);
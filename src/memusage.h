@@ -8,7 +8,9 @@
 #ifndef CASH_MEMUSAGE_H
 #define CASH_MEMUSAGE_H
 
+#include "arenamap.h"
 #include "indirectmap.h"
+#include "prevector.h"
 
 #include <stdlib.h>
 
@@ -141,6 +143,15 @@ static inline size_t IncrementalDynamicUsage(const indirectmap<X, Y>& m)
     return MallocUsage(sizeof(stl_tree_node<std::pair<const X*, Y> >));
 }
 
+// arenamap allocates its elements in chunks, plus a probing table. Count every
+// chunk it holds, as erasing doesn't release any.
+
+template <typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const arenamap<X, Y, Z>& m)
+{
+    return MallocUsage(arenamap<X, Y, Z>::chunk_bytes()) * m.chunk_count() + MallocUsage(m.index_bytes());
+}
+
 template <typename X>
 static inline size_t DynamicUsage(const std::unique_ptr<X>& p)
 {
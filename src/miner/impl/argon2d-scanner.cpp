@@ -0,0 +1,54 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "miner/impl/argon2d-scanner.h"
+#include "hash.h"
+#include "primitives/block.h"
+
+#include <string.h>
+
+namespace
+{
+typedef int (*Argon2dHashFn)(const void* in, const size_t size, const void* out);
+
+Argon2dHashFn GetArgon2dHashFn(unsigned int hash_phase)
+{
+    switch (hash_phase) {
+    case 1:
+        return Argon2d_Phase1_Hash;
+    case 2:
+        return Argon2d_Phase2_Hash;
+    default:
+        return Argon2d_Phase0_Hash;
+    }
+}
+} // namespace
+
+Argon2dScanner::Argon2dScanner(std::size_t batch_size)
+    : _batch_size(batch_size) {}
+
+bool Argon2dScanner::scanNonces(const CBlockHeader& header, std::uint32_t start_nonce, std::uint64_t target, std::uint32_t& result_nonce)
+{
+    static const std::size_t header_size = 80;
+    const std::size_t nonce_offset = BEGIN(header.nNonce) - BEGIN(header.nVersion);
+    unsigned char input[header_size];
+    memcpy(input, BEGIN(header.nVersion), header_size);
+
+    // Only the nonce changes, the phase is fixed by nTime for the whole batch
+    const Argon2dHashFn hash_fn = GetArgon2dHashFn(header.GetHashPhase());
+
+    uint256 hash;
+    std::uint32_t nonce = start_nonce;
+    for (std::size_t i = 0; i < _batch_size; i++, nonce++) {
+        memcpy(input + nonce_offset, &nonce, sizeof(nonce));
+        hash_fn(input, header_size, hash.begin());
+        // Little endian, the most significant 64 bits are the last word
+        if (hash.GetUint64(3) <= target) {
+            _result_hash = hash;
+            result_nonce = nonce;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_MINER_IMPL_ARGON2D_SCANNER_H
+#define CASH_MINER_IMPL_ARGON2D_SCANNER_H
+
+#include "uint256.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class CBlockHeader;
+
+/**
+ * CPU counterpart of the GPU processing units' scanNonces.
+ *
+ * Hashes a batch of nonces over a fixed copy of the header, bypassing the
+ * per call work of CBlockHeader::GetHash (phase lookup, hash cache), and
+ * rejects candidates on the top 64 bits of the hash. Argon2d memory comes
+ * from the calling thread's pool arena, so it is reused across nonces.
+ */
+class Argon2dScanner
+{
+public:
+    explicit Argon2dScanner(std::size_t batch_size);
+
+    std::size_t getBatchSize() const { return _batch_size; }
+
+    /**
+     * Scan nonces [start_nonce, start_nonce + batch size) of header. Returns
+     * whether a nonce had a hash with its top 64 bits <= target, and sets
+     * result_nonce to the first one. Its full hash is available from
+     * getResultHash().
+     */
+    bool scanNonces(const CBlockHeader& header, std::uint32_t start_nonce, std::uint64_t target, std::uint32_t& result_nonce);
+
+    const uint256& getResultHash() const { return _result_hash; }
+
+private:
+    std::size_t _batch_size;
+    uint256 _result_hash;
+};
+
+#endif // CASH_MINER_IMPL_ARGON2D_SCANNER_H
@@ -4,25 +4,62 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "miner/impl/miner-cpu.h"
+#include "hash.h"
+#include "miner/internal/cpu-placement.h"
 #include "primitives/block.h"
+#include "util.h"
 
 
 CPUMiner::CPUMiner(MinerContextRef ctx, std::size_t device_index)
-    : MinerBase(ctx, device_index){};
+    : MinerBase(ctx, device_index),
+      _scanner(DEFAULT_CPU_SCAN_BATCH){};
+
+CPUMiner::~CPUMiner()
+{
+    if (_cpu >= 0)
+        ReleaseMinerCpu(_cpu);
+}
+
+void CPUMiner::PlaceThread(const CBlock& block)
+{
+    _placed = true;
+    if (!GetBoolArg("-minerpinthreads", DEFAULT_MINER_PIN_THREADS))
+        return;
+
+    // The Argon2d arena is allocated by the first hash, after pinning, so it lands on the local node
+    _cpu = AcquireMinerCpu((std::size_t)Argon2d_MemoryCost(block.GetHashPhase()) * 1024);
+    if (_cpu >= 0 && PinCurrentThreadToCpu(_cpu)) {
+        LogPrintf("CashMiner -- CPU miner thread pinned to logical CPU %d\n", _cpu);
+    } else {
+        if (_cpu >= 0)
+            ReleaseMinerCpu(_cpu);
+        _cpu = -1;
+        LogPrintf("CashMiner -- no free core to pin CPU miner thread, running unpinned\n");
+    }
+}
 
 int64_t CPUMiner::TryMineBlock(CBlock& block)
 {
-    int64_t hashes_done = 0;
-    while (true) {
-        uint256 hash = block.GetHash();
-        if (UintToArith256(hash) <= _hash_target) {
-            this->ProcessFoundSolution(block, hash);
-            break;
-        }
-        block.nNonce += 1;
-        hashes_done += 1;
-        if ((block.nNonce & 0xFF) == 0)
-            break;
+    if (!_placed)
+        PlaceThread(block);
+
+    const std::uint64_t scan_target = ArithToUint256(_hash_target).GetUint64(3);
+    const std::uint32_t start_nonce = block.nNonce;
+    std::uint32_t result_nonce;
+    if (!_scanner.scanNonces(block, start_nonce, scan_target, result_nonce)) {
+        // Increase nNonce for the next batch
+        block.nNonce += _scanner.getBatchSize();
+        return _scanner.getBatchSize();
+    }
+
+    // The scan only compared the top 64 bits of the hash
+    const uint256 hash = _scanner.getResultHash();
+    block.nNonce = result_nonce;
+    if (UintToArith256(hash) <= _hash_target) {
+        block.SetCachedHash(hash);
+        this->ProcessFoundSolution(block, hash);
     }
-    return hashes_done;
+    // Resume after the candidate
+    block.nNonce += 1;
+    return result_nonce - start_nonce + 1;
 }
@@ -5,9 +5,13 @@
 #ifndef CASH_MINER_IMPL_CPU_H
 #define CASH_MINER_IMPL_CPU_H
 
+#include "miner/impl/argon2d-scanner.h"
 #include "miner/internal/miner-base.h"
 
 
+/** Nonces hashed per TryMineBlock call, between template refresh checks */
+static const std::size_t DEFAULT_CPU_SCAN_BATCH = 256;
+
 /**
  * Cash CPU miner.
  */
@@ -15,7 +19,7 @@ class CPUMiner final : public MinerBase
 {
 public:
     CPUMiner(MinerContextRef ctx, std::size_t device_index);
-    virtual ~CPUMiner() = default;
+    virtual ~CPUMiner();
 
     static unsigned int TotalDevices()
     {
@@ -31,6 +35,14 @@ public:
 
 protected:
     virtual int64_t TryMineBlock(CBlock& block) override;
+
+private:
+    // Pins the thread to a core with -minerpinthreads, before its first hash
+    void PlaceThread(const CBlock& block);
+
+    Argon2dScanner _scanner;
+    bool _placed = false;
+    int _cpu = -1;
 };
 
 #endif // CASH_MINER_IMPL_CPU_H
@@ -0,0 +1,217 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "miner/internal/cpu-placement.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+#if defined(__linux__)
+std::string ReadSysFile(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+/** Parse a kernel CPU list such as "0-3,8-11" */
+std::vector<int> ParseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty())
+            continue;
+        std::size_t dash = range.find('-');
+        int first = atoi(range.substr(0, dash).c_str());
+        int last = dash == std::string::npos ? first : atoi(range.substr(dash + 1).c_str());
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/** Parse a cache size such as "1024K" */
+std::size_t ParseCacheSize(const std::string& size)
+{
+    std::size_t bytes = strtoul(size.c_str(), NULL, 10);
+    if (!size.empty() && size.back() == 'K')
+        bytes <<= 10;
+    else if (!size.empty() && size.back() == 'M')
+        bytes <<= 20;
+    return bytes;
+}
+
+std::string CpuPath(int cpu)
+{
+    return "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+}
+
+int GetCpuNode(int cpu)
+{
+    int node = 0;
+    DIR* dir = opendir(CpuPath(cpu).c_str());
+    if (!dir)
+        return node;
+    while (struct dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4])) {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+/** Bytes of the L2 and L3 caches of cpu available to each physical core sharing them */
+std::size_t GetCoreCacheShare(int cpu, std::size_t smt_width)
+{
+    std::size_t share = 0;
+    for (int index = 0;; index++) {
+        const std::string path = CpuPath(cpu) + "/cache/index" + std::to_string(index);
+        const std::string level = ReadSysFile(path + "/level");
+        if (level.empty())
+            break;
+        if (atoi(level.c_str()) < 2 || ReadSysFile(path + "/type") == "Instruction")
+            continue;
+        std::size_t sharing = ParseCpuList(ReadSysFile(path + "/shared_cpu_list")).size() / std::max<std::size_t>(smt_width, 1);
+        share += ParseCacheSize(ReadSysFile(path + "/size")) / std::max<std::size_t>(sharing, 1);
+    }
+    return share;
+}
+#endif // __linux__
+
+class CpuPlacement
+{
+public:
+    CpuPlacement();
+
+    int Acquire(std::size_t working_set);
+    void Release(int cpu);
+
+private:
+    std::mutex _mutex;
+    // One logical CPU per physical core, alternating between NUMA nodes
+    std::vector<int> _primaries;
+    // The remaining SMT siblings, in the same order
+    std::vector<int> _siblings;
+    // L2 and L3 bytes per physical core
+    std::size_t _core_cache = 0;
+    std::set<int> _used;
+};
+
+CpuPlacement::CpuPlacement()
+{
+#if defined(__linux__)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+
+    // Logical CPUs we may run on, by (package, core)
+    std::map<std::pair<int, int>, std::vector<int> > cores;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        const std::string package = ReadSysFile(CpuPath(cpu) + "/topology/physical_package_id");
+        const std::string core = ReadSysFile(CpuPath(cpu) + "/topology/core_id");
+        if (package.empty() || core.empty())
+            continue;
+        cores[std::make_pair(atoi(package.c_str()), atoi(core.c_str()))].push_back(cpu);
+    }
+    if (cores.empty())
+        return;
+
+    std::map<int, std::vector<std::vector<int> > > nodes;
+    for (const auto& core : cores)
+        nodes[GetCpuNode(core.second.front())].push_back(core.second);
+
+    for (std::size_t i = 0;; i++) {
+        bool any = false;
+        for (const auto& node : nodes) {
+            if (i >= node.second.size())
+                continue;
+            any = true;
+            _primaries.push_back(node.second[i].front());
+            _siblings.insert(_siblings.end(), node.second[i].begin() + 1, node.second[i].end());
+        }
+        if (!any)
+            break;
+    }
+
+    _core_cache = GetCoreCacheShare(_primaries.front(), cores.begin()->second.size());
+#endif // __linux__
+}
+
+int CpuPlacement::Acquire(std::size_t working_set)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int cpu : _primaries) {
+        if (_used.insert(cpu).second)
+            return cpu;
+    }
+    // Two threads on one core split its cache
+    if (_core_cache >= 2 * working_set) {
+        for (int cpu : _siblings) {
+            if (_used.insert(cpu).second)
+                return cpu;
+        }
+    }
+    return -1;
+}
+
+void CpuPlacement::Release(int cpu)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _used.erase(cpu);
+}
+
+CpuPlacement& GetCpuPlacement()
+{
+    static CpuPlacement placement;
+    return placement;
+}
+} // namespace
+
+int AcquireMinerCpu(std::size_t working_set)
+{
+    return GetCpuPlacement().Acquire(working_set);
+}
+
+void ReleaseMinerCpu(int cpu)
+{
+    GetCpuPlacement().Release(cpu);
+}
+
+bool PinCurrentThreadToCpu(int cpu)
+{
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
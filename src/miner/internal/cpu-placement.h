@@ -0,0 +1,33 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_INTERNAL_CPU_PLACEMENT_H
+#define CASH_INTERNAL_CPU_PLACEMENT_H
+
+#include <cstddef>
+
+/** Default for -minerpinthreads */
+static const bool DEFAULT_MINER_PIN_THREADS = false;
+
+/**
+ * Placement of CPU miner threads on logical CPUs.
+ *
+ * Physical cores are handed out first, alternating between NUMA nodes, so
+ * threads neither migrate nor share a core while others sit idle. SMT
+ * siblings are only used once the per-thread Argon2d working set fits twice
+ * into a core's share of L2 and L3. A pinned thread allocates and pre-faults
+ * its Argon2d arena itself, so first touch keeps it on the local node.
+ *
+ * Topology is read from sysfs and pinning is only supported on Linux;
+ * elsewhere no CPU is ever handed out and threads stay unpinned.
+ */
+
+/** Reserve a logical CPU for a thread hashing with working_set bytes, -1 if none is suitable */
+int AcquireMinerCpu(std::size_t working_set);
+/** Return a CPU reserved by AcquireMinerCpu */
+void ReleaseMinerCpu(int cpu);
+/** Restrict the calling thread to the logical CPU */
+bool PinCurrentThreadToCpu(int cpu);
+
+#endif // CASH_INTERNAL_CPU_PLACEMENT_H
@@ -1,4 +1,3 @@
-
 // Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
@@ -6,33 +5,109 @@
 #include "miner/internal/hash-rate-counter.h"
 #include "utiltime.h"
 
+#include <algorithm>
+#include <cmath>
+
 
-void HashRateCounter::Increment(int64_t amount)
+HashRateCounter::~HashRateCounter()
 {
-    // Set start time if not set and return
-    if (_timer_start == 0) {
-        Reset();
-        return;
-    }
-    // Increment hashes done
-    _count += amount;
+    // Keep the totals of a finished miner thread
     if (_parent) {
-        _parent->Increment(amount);
+        _parent->_count += _count;
+        _parent->_found += _found;
+        _parent->_stale += _stale;
+        _parent->_rejected += _rejected;
+    }
+}
+
+HashRateCounter::operator int64_t() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _rate;
+}
+
+HashRateCounterRef HashRateCounter::MakeChild()
+{
+    HashRateCounterRef child = std::make_shared<HashRateCounter>(shared_from_this());
+    std::lock_guard<std::mutex> lock(_mutex);
+    _children.push_back(child);
+    return child;
+}
+
+std::vector<HashRateCounterRef> HashRateCounter::Children() const
+{
+    std::vector<HashRateCounterRef> children;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& weak : _children) {
+        if (HashRateCounterRef child = weak.lock())
+            children.push_back(child);
     }
-    // Ignore until at least 4 seconds passed
-    if (GetTimeMillis() - _timer_start < 4000) {
+    return children;
+}
+
+void HashRateCounter::Sample(int64_t now_millis)
+{
+    std::vector<HashRateCounterRef> children = Children();
+    for (const auto& child : children)
+        child->Sample(now_millis);
+    const int64_t hashes = GetStats().hashes;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _children.erase(std::remove_if(_children.begin(), _children.end(),
+                        [](const std::weak_ptr<HashRateCounter>& weak) { return weak.expired(); }),
+        _children.end());
+    if (_sample_time == 0 || now_millis <= _sample_time) {
+        _sample_time = now_millis;
+        _sample_hashes = hashes;
         return;
     }
-    // Set count per second
-    _count_per_sec = 1000.0 * _count / (GetTimeMillis() - _timer_start);
-    // Reset timer and count
-    _count = 0;
-    _timer_start = GetTimeMillis();
+    const double elapsed = (now_millis - _sample_time) / 1000.0;
+    // A retiring child can briefly be missed, never report a negative rate
+    _rate = std::max<int64_t>(0, hashes - _sample_hashes) / elapsed;
+    _rate_1m += (1.0 - std::exp(-elapsed / 60.0)) * (_rate - _rate_1m);
+    _rate_5m += (1.0 - std::exp(-elapsed / 300.0)) * (_rate - _rate_5m);
+    _rate_15m += (1.0 - std::exp(-elapsed / 900.0)) * (_rate - _rate_15m);
+    _sample_time = now_millis;
+    _sample_hashes = hashes;
 }
 
 void HashRateCounter::Reset()
 {
-    _count = 0;
-    _count_per_sec = 0;
-    _timer_start = GetTimeMillis();
+    const int64_t hashes = GetStats().hashes;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rate = _rate_1m = _rate_5m = _rate_15m = 0;
+    _sample_time = GetTimeMillis();
+    _sample_hashes = hashes;
+    _timer_start = _sample_time;
+}
+
+HashRateCounter::Stats HashRateCounter::GetStats() const
+{
+    Stats stats;
+    for (const auto& child : Children()) {
+        Stats child_stats = child->GetStats();
+        stats.hashes += child_stats.hashes;
+        stats.found += child_stats.found;
+        stats.stale += child_stats.stale;
+        stats.rejected += child_stats.rejected;
+    }
+    stats.hashes += _count;
+    stats.found += _found;
+    stats.stale += _stale;
+    stats.rejected += _rejected;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.rate = _rate;
+    stats.rate_1m = _rate_1m;
+    stats.rate_5m = _rate_5m;
+    stats.rate_15m = _rate_15m;
+    return stats;
+}
+
+std::vector<HashRateCounter::Stats> HashRateCounter::GetChildStats() const
+{
+    std::vector<Stats> stats;
+    for (const auto& child : Children())
+        stats.push_back(child->GetStats());
+    return stats;
 }
@@ -7,38 +7,90 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
+/** Seconds between hash rate samples */
+static const int64_t HASH_RATE_SAMPLE_INTERVAL = 5;
 
 struct HashRateCounter;
 using HashRateCounterRef = std::shared_ptr<HashRateCounter>;
 
 /**
  * Hash rate counter struct.
+ *
+ * Each miner thread counts into its own child counter with relaxed atomic
+ * adds only. Sample() runs periodically on the scheduler, sums the tree and
+ * updates the current rate and its 1, 5 and 15 minute moving averages.
  */
 struct HashRateCounter : public std::enable_shared_from_this<HashRateCounter> {
+public:
+    /** Totals and rates of a counter including its children */
+    struct Stats {
+        int64_t hashes = 0;
+        int64_t found = 0;
+        int64_t stale = 0;
+        int64_t rejected = 0;
+        double rate = 0;
+        double rate_1m = 0;
+        double rate_5m = 0;
+        double rate_15m = 0;
+    };
+
 private:
+    // Own counts, plus the counts of destroyed children
     std::atomic<int64_t> _count{0};
+    std::atomic<int64_t> _found{0};
+    std::atomic<int64_t> _stale{0};
+    std::atomic<int64_t> _rejected{0};
     std::atomic<int64_t> _timer_start{0};
-    std::atomic<int64_t> _count_per_sec{0};
 
     HashRateCounterRef _parent;
 
+    // Children and sampled rates, never touched by the counting threads
+    mutable std::mutex _mutex;
+    std::vector<std::weak_ptr<HashRateCounter> > _children;
+    int64_t _sample_time = 0;
+    int64_t _sample_hashes = 0;
+    double _rate = 0;
+    double _rate_1m = 0;
+    double _rate_5m = 0;
+    double _rate_15m = 0;
+
+    // Returns live children, dropping destroyed ones
+    std::vector<HashRateCounterRef> Children() const;
+
 public:
     explicit HashRateCounter() : _parent(nullptr){};
     explicit HashRateCounter(HashRateCounterRef parent) : _parent(parent){};
+    ~HashRateCounter();
 
     // Returns hash rate per second
-    operator int64_t() { return _count_per_sec; };
+    operator int64_t() const;
 
     // Creates new child counter
-    HashRateCounterRef MakeChild() { return std::make_shared<HashRateCounter>(shared_from_this()); }
+    HashRateCounterRef MakeChild();
 
     // Increments counter
-    void Increment(int64_t amount);
+    void Increment(int64_t amount) { _count.fetch_add(amount, std::memory_order_relaxed); }
 
-    // Resets counter and timer
+    // Counts an accepted, stale or rejected solution
+    void IncrementFound() { _found.fetch_add(1, std::memory_order_relaxed); }
+    void IncrementStale() { _stale.fetch_add(1, std::memory_order_relaxed); }
+    void IncrementRejected() { _rejected.fetch_add(1, std::memory_order_relaxed); }
+
+    // Updates the rates of this counter and its children
+    void Sample(int64_t now_millis);
+
+    // Resets rates and timer
     void Reset();
 
+    // Returns totals and rates including children
+    Stats GetStats() const;
+
+    // Returns totals and rates of each child
+    std::vector<Stats> GetChildStats() const;
+
     // Returns start time
     int64_t start() const { return _timer_start; };
 };
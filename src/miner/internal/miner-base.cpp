@@ -7,6 +7,7 @@
 
 #include "miner/internal/miner-base.h"
 #include "chainparams.h"
+#include "crypto/argon2d/workers.h"
 #include "miner/miner-util.h"
 #include "primitives/block.h"
 #include "util.h"
@@ -35,26 +36,28 @@ void MinerBase::Loop()
     LogPrintf("CashMiner -- started on %s#%d\n", DeviceName(), _device_index);
     SetThreadPriority(THREAD_PRIORITY_LOWEST);
     RenameThread(tfm::format("Cash-%s-miner-%d", DeviceName(), _device_index).data());
+    // Every miner thread hashes on its own core, don't borrow the lane workers
+    Argon2dSetThreadParallel(false);
 
     CBlock block;
     CBlockIndex* chain_tip = nullptr;
-    int64_t block_time = 0;
+    uint64_t generation = 0;
     std::shared_ptr<CBlockTemplate> block_template = {nullptr};
 
     try {
         while (true) {
             // Update block and tip if changed
-            if (block_time != _ctx->shared->block_time()) {
+            if (generation != _ctx->shared->generation()) {
+                // generation, template and tip all come from one published snapshot
+                MinerTemplateRef current = _ctx->shared->current_template();
+                generation = current->generation;
                 // set new block template
-                block_template = _ctx->shared->block_template();
+                block_template = current->block_template;
                 block = block_template->block;
                 // set block reserve script
                 SetBlockPubkeyScript(block, _coinbase_script->reserveScript);
-                // set block flag only after template
-                // so we've waited for RecreateBlock
-                block_time = _ctx->shared->block_time();
                 // block template chain tip
-                chain_tip = _ctx->shared->tip();
+                chain_tip = current->tip;
             }
             // Make sure we have a tip
             assert(chain_tip != nullptr);
@@ -74,19 +77,19 @@ void MinerBase::Loop()
                 // Check for stop or if block needs to be rebuilt
                 boost::this_thread::interruption_point();
                 // Check if block was recreated
-                if (block_time != _ctx->shared->block_time()) {
+                if (generation != _ctx->shared->generation()) {
                     break;
                 }
                 // Recreate block if nonce too big
                 if (block.nNonce >= 0xffff0000) {
-                    _ctx->shared->RecreateBlock();
+                    _ctx->shared->RequestRecreate(true);
                     break;
                 }
                 // Update block time
                 if (UpdateTime(block, _ctx->chainparams().GetConsensus(), chain_tip) < 0) {
                     // Recreate the block if the clock has run backwards,
                     // so that we can use the correct time.
-                    _ctx->shared->RecreateBlock();
+                    _ctx->shared->RequestRecreate(true);
                     break;
                 }
                 if (_ctx->chainparams().GetConsensus().fPowAllowMinDifficultyBlocks) {
@@ -109,7 +112,20 @@ void MinerBase::ProcessFoundSolution(const CBlock& block, const uint256& hash)
     // Found a solution
     SetThreadPriority(THREAD_PRIORITY_NORMAL);
     LogPrintf("CashMiner%s:\n proof-of-work found  \n  hash: %s  \ntarget: %s\n", DeviceName(), hash.GetHex(), _hash_target.GetHex());
-    ProcessBlockFound(block, _ctx->chainparams());
+    if (ProcessBlockFound(block, _ctx->chainparams())) {
+        _ctx->counter->IncrementFound();
+    } else {
+        // A solution built on an outdated tip is stale, anything else was rejected
+        bool stale;
+        {
+            LOCK(cs_main);
+            stale = block.hashPrevBlock != chainActive.Tip()->GetBlockHash();
+        }
+        if (stale)
+            _ctx->counter->IncrementStale();
+        else
+            _ctx->counter->IncrementRejected();
+    }
     SetThreadPriority(THREAD_PRIORITY_LOWEST);
     _coinbase_script->KeepScript();
 
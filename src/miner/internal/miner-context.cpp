@@ -5,6 +5,8 @@
 #include "miner/internal/miner-context.h"
 #include "miner/miner-util.h"
 #include "txmempool.h"
+#include "util.h"
+#include "utiltime.h"
 #include "validation.h"
 
 MinerContext::MinerContext(const CChainParams& chainparams_, CConnman& connman_)
@@ -14,17 +16,108 @@ MinerContext::MinerContext(const CChainParams& chainparams_, CConnman& connman_)
 MinerContext::MinerContext(MinerSharedContextRef shared_, HashRateCounterRef counter_)
     : counter(counter_), shared(shared_){};
 
+MinerSharedContext::MinerSharedContext(const CChainParams& chainparams_, CConnman& connman_)
+    : chainparams(chainparams_),
+      connman(connman_),
+      _debounce_ms(std::max<int64_t>(0, GetArg("-minertxdebounce", DEFAULT_MINER_TX_DEBOUNCE)))
+{
+    for (auto& bucket : _template_ages)
+        bucket = 0;
+}
+
+MinerSharedContext::~MinerSharedContext()
+{
+    {
+        std::lock_guard<std::mutex> lock(_request_mutex);
+        _stop = true;
+    }
+    _request_cv.notify_one();
+    if (_builder.joinable())
+        _builder.join();
+}
+
 void MinerSharedContext::RecreateBlock()
 {
-    // Then we acquire unique lock so that miners wait
-    // for the new block to be created
-    boost::unique_lock<boost::shared_mutex> guard(_mutex);
+    // Miners keep hashing the published template while a new one is built
+    std::lock_guard<std::mutex> guard(_build_mutex);
     uint32_t txn_time = mempool.GetTransactionsUpdated();
+    MinerTemplateRef previous = current_template();
     // pass if nothing changed
-    if (_chain_tip == chainActive.Tip() && _last_txn == txn_time)
+    if (previous && previous->tip == chainActive.Tip() && previous->last_txn == txn_time)
         return;
-    _chain_tip = chainActive.Tip();
-    _block_time = GetTime();
-    _block_template = CreateNewBlock(chainparams);
-    _last_txn = txn_time;
+    std::shared_ptr<MinerTemplate> next = std::make_shared<MinerTemplate>();
+    next->generation = previous ? previous->generation + 1 : 1;
+    next->last_txn = txn_time;
+    {
+        // keep the tip consistent with the template built on it
+        LOCK(cs_main);
+        next->tip = chainActive.Tip();
+        next->block_template = CreateNewBlock(chainparams);
+    }
+    // miners see the tip, template and generation change together
+    std::atomic_store(&_template, MinerTemplateRef(next));
+    // record how long the replaced template was mined on
+    const int64_t now = GetTimeMillis();
+    const int64_t published = _publish_time.exchange(now);
+    if (published != 0) {
+        size_t bucket = 0;
+        while (bucket < MINER_TEMPLATE_AGE_BUCKET_COUNT - 1 && (now - published) > MINER_TEMPLATE_AGE_BUCKETS[bucket] * 1000)
+            bucket++;
+        _template_ages[bucket]++;
+    }
+}
+
+int64_t MinerSharedContext::template_age() const
+{
+    const int64_t published = _publish_time;
+    if (published == 0)
+        return 0;
+    return (GetTimeMillis() - published) / 1000;
+}
+
+std::vector<uint64_t> MinerSharedContext::template_age_histogram() const
+{
+    std::vector<uint64_t> histogram;
+    for (const auto& bucket : _template_ages)
+        histogram.push_back(bucket);
+    return histogram;
+}
+
+void MinerSharedContext::RequestRecreate(bool new_tip)
+{
+    std::lock_guard<std::mutex> lock(_request_mutex);
+    const int64_t due = GetTimeMillis() + (new_tip ? 0 : _debounce_ms);
+    if (_request_due == 0 || due < _request_due)
+        _request_due = due;
+    if (!_builder.joinable())
+        _builder = std::thread(&MinerSharedContext::BuilderThread, this);
+    _request_cv.notify_one();
+}
+
+void MinerSharedContext::BuilderThread()
+{
+    RenameThread("cash-minertmpl");
+    std::unique_lock<std::mutex> lock(_request_mutex);
+    while (!_stop) {
+        if (_request_due == 0) {
+            _request_cv.wait(lock);
+            continue;
+        }
+        const int64_t now = GetTimeMillis();
+        if (now < _request_due) {
+            _request_cv.wait_for(lock, std::chrono::milliseconds(_request_due - now));
+            continue;
+        }
+        _request_due = 0;
+        lock.unlock();
+        const uint64_t generation = this->generation();
+        try {
+            RecreateBlock();
+        } catch (const std::exception& e) {
+            LogPrintf("CashMiner -- block template rebuild failed: %s\n", e.what());
+        }
+        lock.lock();
+        if (generation != this->generation() && _publish_handler)
+            _publish_handler();
+    }
 }
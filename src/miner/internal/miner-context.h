@@ -7,10 +7,13 @@
 
 #include "miner/internal/hash-rate-counter.h"
 
-#include <boost/thread/locks.hpp>
-#include <boost/thread/shared_mutex.hpp>
-
 #include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class CBlock;
 class CChainParams;
@@ -26,49 +29,97 @@ class MinersController;
 /** Miner context shared_ptr */
 using MinerContextRef = std::shared_ptr<MinerContext>;
 
+/** Default for -minertxdebounce, in milliseconds */
+static const int64_t DEFAULT_MINER_TX_DEBOUNCE = 5000;
+
+/** Upper bounds in seconds of the template age histogram buckets, the last bucket is open */
+static const int64_t MINER_TEMPLATE_AGE_BUCKETS[] = {1, 5, 15, 30, 60, 120, 300};
+static const size_t MINER_TEMPLATE_AGE_BUCKET_COUNT = sizeof(MINER_TEMPLATE_AGE_BUCKETS) / sizeof(MINER_TEMPLATE_AGE_BUCKETS[0]) + 1;
+
+/** A published block template together with the chain tip it was built on */
+struct MinerTemplate {
+    // incremented for every published template
+    uint64_t generation;
+    // chain tip the template was built on
+    CBlockIndex* tip;
+    // mempool update counter the template was built at
+    uint32_t last_txn;
+    std::shared_ptr<CBlockTemplate> block_template;
+};
+
+using MinerTemplateRef = std::shared_ptr<const MinerTemplate>;
+
 struct MinerSharedContext {
 public:
     const CChainParams& chainparams;
     CConnman& connman;
 
-    MinerSharedContext(const CChainParams& chainparams_, CConnman& connman_)
-        : chainparams(chainparams_), connman(connman_){};
+    MinerSharedContext(const CChainParams& chainparams_, CConnman& connman_);
+    ~MinerSharedContext();
+
+    // Returns the current block template and its chain tip, null before the first build.
+    // Load it once and read all fields from the same snapshot.
+    MinerTemplateRef current_template() const
+    {
+        return std::atomic_load(&_template);
+    }
 
-    // Returns chain tip of current block template
-    CBlockIndex* tip() const { return _chain_tip; }
+    // Returns generation of the block template, incremented on every rebuild
+    uint64_t generation() const
+    {
+        MinerTemplateRef current = current_template();
+        return current ? current->generation : 0;
+    }
 
-    // Returns miner block template creation time
-    int64_t block_time() const { return _block_time; }
+    // Returns seconds since the current block template was published
+    int64_t template_age() const;
 
-    // Returns time of last transaction in the block
-    uint32_t last_txn() const { return _last_txn; }
+    // Returns how many templates lived for each MINER_TEMPLATE_AGE_BUCKETS range before replaced
+    std::vector<uint64_t> template_age_histogram() const;
 
-    // Returns miner block template
-    std::shared_ptr<CBlockTemplate> block_template()
+    // Sets a handler called on the builder thread after each published template
+    void SetPublishHandler(std::function<void()> handler)
     {
-        boost::shared_lock<boost::shared_mutex> guard(_mutex);
-        return _block_template;
+        std::lock_guard<std::mutex> lock(_request_mutex);
+        _publish_handler = handler;
     }
 
 protected:
     friend class MinerBase;
     friend class MinerSignals;
     friend class MinersController;
+    friend class StratumServer;
 
-    // recreates miners block template
+    // recreates miners block template on the calling thread
     void RecreateBlock();
 
+    // Schedules a template rebuild on the builder thread. A new tip is
+    // rebuilt right away, transaction updates are coalesced over
+    // -minertxdebounce. Never blocks the caller on CreateNewBlock.
+    void RequestRecreate(bool new_tip);
+
 private:
-    // current block chain tip
-    std::atomic<CBlockIndex*> _chain_tip{nullptr};
-    // atomic flag incremented on recreated block
-    std::atomic<int64_t> _block_time{0};
-    // last transaction update time
-    std::atomic<uint32_t> _last_txn{0};
-    // shared block template for miners
-    std::shared_ptr<CBlockTemplate> _block_template{nullptr};
-    // mutex protecting multiple threads recreating block
-    mutable boost::shared_mutex _mutex;
+    // Builder thread loop
+    void BuilderThread();
+
+    // published template, replaced as a whole with std::atomic_store
+    MinerTemplateRef _template{nullptr};
+    // serializes template rebuilds
+    std::mutex _build_mutex;
+    // publish time of the current template (GetTimeMillis)
+    std::atomic<int64_t> _publish_time{0};
+    // lifetimes of replaced templates
+    std::atomic<uint64_t> _template_ages[MINER_TEMPLATE_AGE_BUCKET_COUNT];
+
+    // transaction rebuild debounce in milliseconds
+    int64_t _debounce_ms;
+    // pending rebuild deadline (GetTimeMillis), 0 when none
+    int64_t _request_due = 0;
+    bool _stop = false;
+    std::mutex _request_mutex;
+    std::condition_variable _request_cv;
+    std::thread _builder;
+    std::function<void()> _publish_handler;
 };
 
 using MinerSharedContextRef = std::shared_ptr<MinerSharedContext>;
@@ -7,6 +7,7 @@
 #include "miner/internal/miner-context.h"
 #include "miner/miner-util.h"
 #include "net.h"
+#include "utiltime.h"
 #include "validation.h"
 #include "validationinterface.h"
 #include <boost/bind/bind.hpp>
@@ -62,6 +63,11 @@ int64_t MinersController::GetHashRate() const
 #endif // ENABLE_GPU
 }
 
+void MinersController::SampleStats()
+{
+    _ctx->counter->Sample(GetTimeMillis());
+}
+
 MinerSignals::MinerSignals(MinersController* ctr)
     : _ctr(ctr),
       _node(_ctr->ctx()->connman().ConnectSignalNode(boost::bind(&MinerSignals::NotifyNode, this, _1))),
@@ -84,8 +90,8 @@ void MinerSignals::NotifyBlock(const CBlockIndex* index_new, const CBlockIndex*
     // Compare with current tip (checks for unexpected behaviour or old block)
     if (index_new != chainActive.Tip())
         return;
-    // Create new block template for miners
-    _ctr->_ctx->shared->RecreateBlock();
+    // Rebuild the block template for miners off this thread
+    _ctr->_ctx->shared->RequestRecreate(true);
     // start miners
     if (_ctr->can_start()) {
         _ctr->_group_cpu.Start();
@@ -100,7 +106,6 @@ void MinerSignals::NotifyTransaction(const CTransaction& txn, const CBlockIndex*
     // check if blockchain has synced, has more than 1 peer and is enabled before recreating blocks
     if (IsInitialBlockDownload() || !_ctr->can_start())
         return;
-    if (GetTime() - _ctr->_ctx->shared->last_txn() > 60) {
-        _ctr->_ctx->shared->RecreateBlock();
-    }
+    // Bursts of transactions are coalesced into one rebuild
+    _ctr->_ctx->shared->RequestRecreate(false);
 };
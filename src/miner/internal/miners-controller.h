@@ -44,6 +44,15 @@ public:
     // Gets combined hash rate of GPU and CPU
     int64_t GetHashRate() const;
 
+    // Samples hash rate counters of all miner threads
+    void SampleStats();
+
+    // Returns hash rate counter of all miner threads
+    HashRateCounterRef counter() const { return _ctx->counter; }
+
+    // Returns shared block template context
+    MinerSharedContextRef shared() const { return _ctx->shared; }
+
     // Returns CPU miners thread group
     MinersThreadGroup<CPUMiner>& group_cpu() { return _group_cpu; }
 
@@ -60,7 +69,11 @@ protected:
     void StartIfEnabled();
 
     // Returns true if enabled, connected and has block.
-    bool can_start() const { return _connected && _enable_start && _ctx->shared->block_template(); }
+    bool can_start() const
+    {
+        MinerTemplateRef current = _ctx->shared->current_template();
+        return _connected && _enable_start && current && current->block_template;
+    }
 
     // Miner signals class
     friend class MinerSignals;
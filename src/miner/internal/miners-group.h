@@ -43,6 +43,9 @@ public:
 
     // Gets hash rate of all threads in the group
     int64_t GetHashRate() const { return *this->_ctx->counter; };
+
+    // Gets hash rate counter of the group, one child per miner thread
+    HashRateCounterRef counter() const { return this->_ctx->counter; };
 };
 
 
@@ -0,0 +1,140 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "miner/internal/stratum-job.h"
+
+#include "consensus/merkle.h"
+#include "consensus/params.h"
+#include "miner/miner-util.h"
+#include "serialize.h"
+#include "streams.h"
+#include "validation.h"
+#include "version.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+StratumJob MakeStratumJob(const std::string& id, const CBlock& block_template, int height, const CScript& script)
+{
+    StratumJob job;
+    job.id = id;
+    job.height = height;
+    job.block = block_template;
+    SetBlockPubkeyScript(job.block, script);
+
+    // Height first, then a push of both extranonces for the miner to fill in
+    CMutableTransaction coinbase(*job.block.vtx[0]);
+    const CScript prefix = CScript() << height;
+    const std::vector<unsigned char> placeholder(STRATUM_EXTRANONCE1_SIZE + STRATUM_EXTRANONCE2_SIZE, 0);
+    coinbase.vin[0].scriptSig = (CScript(prefix) << placeholder) + COINBASE_FLAGS;
+    assert(coinbase.vin[0].scriptSig.size() <= 100);
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << coinbase;
+    // nVersion, input count, coinbase outpoint, script length, height and the extranonce push opcode
+    const size_t offset = 4 + 1 + 36 + GetSizeOfCompactSize(coinbase.vin[0].scriptSig.size()) + prefix.size() + 1;
+    assert((unsigned char)ss[offset - 1] == placeholder.size());
+    job.coinb1.assign(ss.begin(), ss.begin() + offset);
+    job.coinb2.assign(ss.begin() + offset + placeholder.size(), ss.end());
+
+    job.block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    job.merkle_branch = BlockMerkleBranch(job.block, 0);
+    job.target.SetCompact(job.block.nBits);
+    return job;
+}
+
+bool AssembleStratumBlock(const StratumJob& job, const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2, uint32_t ntime, uint32_t nonce, CBlock& block)
+{
+    if (extranonce1.size() != STRATUM_EXTRANONCE1_SIZE || extranonce2.size() != STRATUM_EXTRANONCE2_SIZE)
+        return false;
+
+    std::vector<unsigned char> coinbase_data(job.coinb1);
+    coinbase_data.insert(coinbase_data.end(), extranonce1.begin(), extranonce1.end());
+    coinbase_data.insert(coinbase_data.end(), extranonce2.begin(), extranonce2.end());
+    coinbase_data.insert(coinbase_data.end(), job.coinb2.begin(), job.coinb2.end());
+    CMutableTransaction coinbase;
+    CDataStream ss(coinbase_data, SER_NETWORK, PROTOCOL_VERSION);
+    ss >> coinbase;
+
+    block = job.block;
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    block.hashMerkleRoot = ComputeMerkleRootFromBranch(block.vtx[0]->GetHash(), job.merkle_branch, 0);
+    block.nTime = ntime;
+    block.nNonce = nonce;
+    return true;
+}
+
+arith_uint256 StratumShareTarget(double difficulty, const Consensus::Params& params)
+{
+    static const uint64_t SCALE = 1000000;
+    const arith_uint256 limit = UintToArith256(params.powLimit);
+    if (difficulty <= 1.0)
+        return limit;
+    arith_uint256 target = limit / (uint64_t)(difficulty * SCALE);
+    target *= SCALE;
+    return target;
+}
+
+StratumShareResult CheckStratumShare(const uint256& hash, const StratumJob& job, const arith_uint256& share_target)
+{
+    const arith_uint256 hash_arith = UintToArith256(hash);
+    if (hash_arith <= job.target)
+        return STRATUM_SHARE_BLOCK;
+    if (hash_arith <= share_target)
+        return STRATUM_SHARE_ACCEPTED;
+    return STRATUM_SHARE_LOW;
+}
+
+bool StratumJobQueue::Push(const StratumJob& job)
+{
+    // Shares against the previous tip can no longer become blocks
+    const bool clean = _jobs.empty() || _jobs.back().block.hashPrevBlock != job.block.hashPrevBlock;
+    if (clean)
+        _jobs.clear();
+    _jobs.push_back(job);
+    if (_jobs.size() > MAX_STRATUM_JOBS)
+        _jobs.pop_front();
+    return clean;
+}
+
+const StratumJob* StratumJobQueue::Find(const std::string& id) const
+{
+    auto it = std::find_if(_jobs.begin(), _jobs.end(), [&id](const StratumJob& job) { return job.id == id; });
+    return it == _jobs.end() ? nullptr : &*it;
+}
+
+const StratumJob* StratumJobQueue::Latest() const
+{
+    return _jobs.empty() ? nullptr : &_jobs.back();
+}
+
+StratumShareLog::Result StratumShareLog::Record(const std::string& job_id, const std::string& share)
+{
+    std::set<std::string>& shares = _shares[job_id];
+    if (shares.count(share))
+        return SHARE_DUPLICATE;
+    if (shares.size() >= MAX_STRATUM_SHARES_PER_JOB)
+        return SHARE_LIMIT;
+    shares.insert(share);
+    return SHARE_NEW;
+}
+
+void StratumShareLog::Prune(const StratumJobQueue& jobs)
+{
+    for (auto it = _shares.begin(); it != _shares.end();) {
+        if (jobs.Find(it->first))
+            ++it;
+        else
+            it = _shares.erase(it);
+    }
+}
+
+size_t StratumShareLog::size() const
+{
+    size_t count = 0;
+    for (const auto& job : _shares)
+        count += job.second.size();
+    return count;
+}
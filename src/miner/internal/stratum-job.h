@@ -0,0 +1,113 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_MINER_INTERNAL_STRATUM_JOB_H
+#define CASH_MINER_INTERNAL_STRATUM_JOB_H
+
+#include "arith_uint256.h"
+#include "primitives/block.h"
+#include "script/script.h"
+#include "uint256.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Consensus
+{
+struct Params;
+}
+
+/** Bytes of the extranonce assigned to each connection */
+static const size_t STRATUM_EXTRANONCE1_SIZE = 4;
+/** Bytes of the extranonce chosen by the miner */
+static const size_t STRATUM_EXTRANONCE2_SIZE = 4;
+/** Jobs kept for shares submitted against an older template of the same tip */
+static const size_t MAX_STRATUM_JOBS = 16;
+/** Shares a worker may submit against a single job */
+static const size_t MAX_STRATUM_SHARES_PER_JOB = 1024;
+
+/** A block template split around the coinbase extranonces */
+struct StratumJob {
+    std::string id;
+    int height;
+    CBlock block;
+    std::vector<unsigned char> coinb1;
+    std::vector<unsigned char> coinb2;
+    std::vector<uint256> merkle_branch;
+    arith_uint256 target;
+};
+
+/**
+ * Make a job of a block template for the given height. The coinbase pays to
+ * script and its scriptSig is the height followed by a single push of both
+ * extranonces, which coinb1 and coinb2 are split around.
+ */
+StratumJob MakeStratumJob(const std::string& id, const CBlock& block_template, int height, const CScript& script);
+
+/**
+ * Rebuild the block a worker hashed from a job, the worker's extranonces and
+ * the submitted ntime and nonce. Returns false if the extranonces don't have
+ * the sizes the job was split for.
+ */
+bool AssembleStratumBlock(const StratumJob& job, const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2, uint32_t ntime, uint32_t nonce, CBlock& block);
+
+/** Share target, difficulty 1 being the chain's proof-of-work limit */
+arith_uint256 StratumShareTarget(double difficulty, const Consensus::Params& params);
+
+enum StratumShareResult {
+    STRATUM_SHARE_BLOCK,     //!< meets the block target
+    STRATUM_SHARE_ACCEPTED,  //!< meets the worker's share target only
+    STRATUM_SHARE_LOW,       //!< meets neither
+};
+
+/** Classify the hash of a submitted header */
+StratumShareResult CheckStratumShare(const uint256& hash, const StratumJob& job, const arith_uint256& share_target);
+
+/** Jobs workers may submit shares for, all building on the same block */
+class StratumJobQueue
+{
+public:
+    /**
+     * Add a job, dropping the oldest one past MAX_STRATUM_JOBS. A job on
+     * another block drops all queued jobs. Returns whether it did.
+     */
+    bool Push(const StratumJob& job);
+
+    /** Returns the queued job with the given id, null if it is unknown or stale */
+    const StratumJob* Find(const std::string& id) const;
+
+    /** Returns the latest job, null if there is none yet */
+    const StratumJob* Latest() const;
+
+private:
+    std::deque<StratumJob> _jobs;
+};
+
+/** Shares a worker submitted, per queued job */
+class StratumShareLog
+{
+public:
+    enum Result {
+        SHARE_NEW,
+        SHARE_DUPLICATE,
+        SHARE_LIMIT, //!< MAX_STRATUM_SHARES_PER_JOB were submitted for the job already
+    };
+
+    /** Record a share of the job with the given id */
+    Result Record(const std::string& job_id, const std::string& share);
+
+    /** Forget the shares of jobs that are no longer queued */
+    void Prune(const StratumJobQueue& jobs);
+
+    /** Number of shares remembered */
+    size_t size() const;
+
+private:
+    std::map<std::string, std::set<std::string> > _shares;
+};
+
+#endif // CASH_MINER_INTERNAL_STRATUM_JOB_H
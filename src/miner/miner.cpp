@@ -71,6 +71,12 @@ int64_t GetGPUHashRate()
     return 0;
 };
 
+void SampleMinerStats()
+{
+    if (gMiners)
+        gMiners->SampleStats();
+};
+
 void SetCPUMinerThreads(uint8_t target)
 {
     assert(gMiners);
@@ -33,6 +33,9 @@ int64_t GetCPUHashRate();
 /** Gets hash rate of GPU */
 int64_t GetGPUHashRate();
 
+/** Samples hash rate counters, called every HASH_RATE_SAMPLE_INTERVAL seconds */
+void SampleMinerStats();
+
 /** Sets amount of CPU miner threads */
 void SetCPUMinerThreads(uint8_t target);
 /** Sets amount of GPU miner threads */
@@ -0,0 +1,587 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "miner/stratum.h"
+
+#include "arith_uint256.h"
+#include "base58.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "miner/internal/miner-context.h"
+#include "miner/internal/stratum-job.h"
+#include "miner/miner-util.h"
+#include "netbase.h"
+#include "primitives/block.h"
+#include "rpc/protocol.h"
+#include "script/standard.h"
+#include "timedata.h"
+#include "util.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "validationinterface.h"
+
+#include <univalue.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <event2/listener.h>
+#include <event2/thread.h>
+
+#include <boost/bind/bind.hpp>
+#include <boost/signals2/signal.hpp>
+#include <boost/thread.hpp>
+
+using namespace boost::placeholders;
+
+/** Maximum length of a request line, guards against memory exhaustion */
+static const size_t MAX_STRATUM_LINE_LENGTH = 16384;
+/** Highest share difficulty a worker may ask for */
+static const double MAX_STRATUM_DIFFICULTY = 1e12;
+/** Shares per second a worker may submit on average, each is hashed on the event thread */
+static const double MAX_STRATUM_SUBMIT_RATE = 10;
+/** Shares a worker may submit at once above the average rate */
+static const double MAX_STRATUM_SUBMIT_BURST = 20;
+
+/** Stratum error codes */
+enum StratumErrorCode {
+    STRATUM_OTHER = 20,
+    STRATUM_JOB_NOT_FOUND = 21,
+    STRATUM_DUPLICATE_SHARE = 22,
+    STRATUM_LOW_DIFFICULTY = 23,
+    STRATUM_UNAUTHORIZED = 24,
+    STRATUM_NOT_SUBSCRIBED = 25,
+};
+
+static std::vector<CSubNet> stratum_allow_subnets;
+
+/** Check if a worker may connect, based on -stratumallowip */
+static bool ClientAllowed(const CNetAddr& netaddr)
+{
+    if (!netaddr.IsValid())
+        return false;
+    for (const CSubNet& subnet : stratum_allow_subnets)
+        if (subnet.Match(netaddr))
+            return true;
+    return false;
+}
+
+/** Initialize ACL list for the Stratum server */
+static bool InitStratumAllowList()
+{
+    stratum_allow_subnets.clear();
+    CNetAddr localv4;
+    CNetAddr localv6;
+    LookupHost("127.0.0.1", localv4, false);
+    LookupHost("::1", localv6, false);
+    stratum_allow_subnets.push_back(CSubNet(localv4, 8)); // always allow IPv4 local subnet
+    stratum_allow_subnets.push_back(CSubNet(localv6));    // always allow IPv6 localhost
+    if (mapMultiArgs.count("-stratumallowip")) {
+        for (const std::string& strAllow : mapMultiArgs.at("-stratumallowip")) {
+            CSubNet subnet;
+            LookupSubNet(strAllow.c_str(), subnet);
+            if (!subnet.IsValid()) {
+                LogPrintf("stratum: Invalid -stratumallowip subnet specification: %s\n", strAllow);
+                return false;
+            }
+            stratum_allow_subnets.push_back(subnet);
+        }
+    }
+    std::string strAllowed;
+    for (const CSubNet& subnet : stratum_allow_subnets)
+        strAllowed += subnet.ToString() + " ";
+    LogPrint("stratum", "stratum: Allowing connections from: %s\n", strAllowed);
+    return true;
+}
+
+namespace
+{
+UniValue StratumError(int code, const std::string& message)
+{
+    UniValue error(UniValue::VARR);
+    error.push_back(code);
+    error.push_back(message);
+    error.push_back(NullUniValue);
+    return error;
+}
+
+/** Previous block hash as sent in mining.notify: header byte order with each 32-bit word reversed */
+std::string HexPrevHash(const uint256& hash)
+{
+    std::vector<unsigned char> bytes(hash.begin(), hash.end());
+    for (size_t i = 0; i < bytes.size(); i += 4)
+        std::reverse(bytes.begin() + i, bytes.begin() + i + 4);
+    return HexStr(bytes);
+}
+
+/** Parse a big endian 32-bit hex value such as ntime or nonce */
+bool ParseHexUint32(const std::string& str, uint32_t& value)
+{
+    if (str.size() != 8 || !IsHex(str))
+        return false;
+    value = strtoul(str.c_str(), NULL, 16);
+    return true;
+}
+} // namespace
+
+class StratumServer;
+
+/** A connected worker */
+struct StratumClient {
+    StratumServer* server;
+    struct bufferevent* bev;
+    std::string address;
+    std::vector<unsigned char> extranonce1;
+    bool subscribed = false;
+    bool authorized = false;
+    double difficulty;
+    // Shares already submitted against the queued jobs
+    StratumShareLog shares;
+    // Submits the worker may still make right away, refilled at MAX_STRATUM_SUBMIT_RATE
+    double submit_allowance = MAX_STRATUM_SUBMIT_BURST;
+    int64_t submit_time = 0;
+};
+
+class StratumServer
+{
+public:
+    StratumServer(const CChainParams& chainparams, CConnman& connman, struct event_base* base, const CScript& script);
+    ~StratumServer();
+
+    bool Listen(const std::string& bind, unsigned short port);
+
+private:
+    const CChainParams& _chainparams;
+    struct event_base* _base;
+    struct evconnlistener* _listener = nullptr;
+    // Activated by the template builder thread
+    struct event* _notify_event = nullptr;
+    CScript _script;
+    MinerSharedContextRef _shared;
+    uint64_t _generation = 0;
+
+    StratumJobQueue _jobs;
+    uint64_t _job_counter = 0;
+    uint32_t _extranonce_counter = 0;
+    std::map<struct bufferevent*, std::unique_ptr<StratumClient> > _clients;
+
+    boost::signals2::scoped_connection _block;
+    boost::signals2::scoped_connection _txn;
+
+    void NotifyBlock(const CBlockIndex* index_new, const CBlockIndex* index_fork, bool fInitialDownload);
+    void NotifyTransaction(const CTransaction& txn, const CBlockIndex* index, int posInBlock);
+
+    void UpdateJob();
+    bool AllowSubmit(StratumClient& client);
+    void Disconnect(StratumClient& client);
+    void Send(StratumClient& client, const UniValue& message);
+    void SendDifficulty(StratumClient& client);
+    void SendJob(StratumClient& client, const StratumJob& job, bool clean);
+    bool HandleLine(StratumClient& client, const std::string& line);
+    UniValue HandleSubmit(StratumClient& client, const UniValue& params);
+
+    static void accept_cb(struct evconnlistener* listener, evutil_socket_t fd, struct sockaddr* addr, int socklen, void* ctx);
+    static void readcb(struct bufferevent* bev, void* ctx);
+    static void eventcb(struct bufferevent* bev, short what, void* ctx);
+    static void notify_cb(evutil_socket_t fd, short what, void* ctx);
+};
+
+StratumServer::StratumServer(const CChainParams& chainparams, CConnman& connman, struct event_base* base, const CScript& script)
+    : _chainparams(chainparams),
+      _base(base),
+      _script(script),
+      _shared(std::make_shared<MinerSharedContext>(chainparams, connman)),
+      _block(GetMainSignals().UpdatedBlockTip.connect(boost::bind(&StratumServer::NotifyBlock, this, _1, _2, _3))),
+      _txn(GetMainSignals().SyncTransaction.connect(boost::bind(&StratumServer::NotifyTransaction, this, _1, _2, _3)))
+{
+    _notify_event = event_new(_base, -1, 0, notify_cb, this);
+    struct event* notify_event = _notify_event;
+    _shared->SetPublishHandler([notify_event] { event_active(notify_event, 0, 0); });
+    _shared->RequestRecreate(true);
+}
+
+StratumServer::~StratumServer()
+{
+    _block.disconnect();
+    _txn.disconnect();
+    // Stops the builder thread before the event it activates goes away
+    _shared->SetPublishHandler(nullptr);
+    _shared.reset();
+    for (auto& client : _clients)
+        bufferevent_free(client.first);
+    _clients.clear();
+    if (_listener)
+        evconnlistener_free(_listener);
+    event_free(_notify_event);
+}
+
+bool StratumServer::Listen(const std::string& bind, unsigned short port)
+{
+    CService service;
+    if (!Lookup(bind.c_str(), service, port, false)) {
+        LogPrintf("stratum: Invalid -stratumbind address '%s'\n", bind);
+        return false;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addrlen = sizeof(addr);
+    if (!service.GetSockAddr((struct sockaddr*)&addr, &addrlen)) {
+        LogPrintf("stratum: Unable to bind to %s\n", service.ToString());
+        return false;
+    }
+    _listener = evconnlistener_new_bind(_base, accept_cb, this, LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1, (struct sockaddr*)&addr, addrlen);
+    if (!_listener) {
+        LogPrintf("stratum: Unable to listen on %s\n", service.ToString());
+        return false;
+    }
+    LogPrintf("stratum: Listening for miners on %s\n", service.ToString());
+    return true;
+}
+
+void StratumServer::NotifyBlock(const CBlockIndex* index_new, const CBlockIndex* index_fork, bool fInitialDownload)
+{
+    if (fInitialDownload)
+        return;
+    _shared->RequestRecreate(true);
+}
+
+void StratumServer::NotifyTransaction(const CTransaction& txn, const CBlockIndex* index, int posInBlock)
+{
+    if (IsInitialBlockDownload())
+        return;
+    _shared->RequestRecreate(false);
+}
+
+void StratumServer::UpdateJob()
+{
+    // The tip and the template come from one published snapshot
+    MinerTemplateRef current = _shared->current_template();
+    if (!current || current->generation == _generation || !current->tip || !current->block_template)
+        return;
+    _generation = current->generation;
+    const CBlockIndex* tip = current->tip;
+
+    const StratumJob job = MakeStratumJob(strprintf("%x", ++_job_counter), current->block_template->block, tip->nHeight + 1, _script);
+    const bool clean = _jobs.Push(job);
+    for (auto& client : _clients)
+        client.second->shares.Prune(_jobs);
+
+    LogPrint("stratum", "stratum: New job %s at height %d (clean=%d)\n", job.id, job.height, clean);
+    for (auto& client : _clients) {
+        if (client.second->subscribed)
+            SendJob(*client.second, *_jobs.Latest(), clean);
+    }
+}
+
+bool StratumServer::AllowSubmit(StratumClient& client)
+{
+    const int64_t now = GetTimeMicros();
+    if (client.submit_time != 0)
+        client.submit_allowance = std::min(MAX_STRATUM_SUBMIT_BURST, client.submit_allowance + (now - client.submit_time) * MAX_STRATUM_SUBMIT_RATE / 1000000);
+    client.submit_time = now;
+    if (client.submit_allowance < 1)
+        return false;
+    client.submit_allowance -= 1;
+    return true;
+}
+
+void StratumServer::Disconnect(StratumClient& client)
+{
+    LogPrint("stratum", "stratum: Worker %s disconnected\n", client.address);
+    struct bufferevent* bev = client.bev;
+    _clients.erase(bev);
+    bufferevent_free(bev);
+}
+
+void StratumServer::Send(StratumClient& client, const UniValue& message)
+{
+    const std::string str = message.write() + "\n";
+    evbuffer_add(bufferevent_get_output(client.bev), str.data(), str.size());
+}
+
+void StratumServer::SendDifficulty(StratumClient& client)
+{
+    UniValue params(UniValue::VARR);
+    params.push_back(client.difficulty);
+    Send(client, JSONRPCRequestObj("mining.set_difficulty", params, NullUniValue));
+}
+
+void StratumServer::SendJob(StratumClient& client, const StratumJob& job, bool clean)
+{
+    UniValue branch(UniValue::VARR);
+    for (const uint256& hash : job.merkle_branch)
+        branch.push_back(HexStr(hash.begin(), hash.end()));
+
+    UniValue params(UniValue::VARR);
+    params.push_back(job.id);
+    params.push_back(HexPrevHash(job.block.hashPrevBlock));
+    params.push_back(HexStr(job.coinb1));
+    params.push_back(HexStr(job.coinb2));
+    params.push_back(branch);
+    params.push_back(strprintf("%08x", job.block.nVersion));
+    params.push_back(strprintf("%08x", job.block.nBits));
+    params.push_back(strprintf("%08x", job.block.nTime));
+    params.push_back(clean);
+    Send(client, JSONRPCRequestObj("mining.notify", params, NullUniValue));
+}
+
+bool StratumServer::HandleLine(StratumClient& client, const std::string& line)
+{
+    UniValue request;
+    if (!request.read(line) || !request.isObject()) {
+        LogPrint("stratum", "stratum: Malformed request from %s\n", client.address);
+        Disconnect(client);
+        return false;
+    }
+    const UniValue& id = find_value(request, "id");
+    const UniValue& method = find_value(request, "method");
+    const UniValue& params = find_value(request, "params");
+
+    UniValue result(NullUniValue);
+    UniValue error(NullUniValue);
+    bool send_difficulty = false;
+    bool send_job = false;
+    try {
+        const std::string strMethod = method.get_str();
+        if (strMethod == "mining.subscribe") {
+            UniValue subscription(UniValue::VARR);
+            for (const char* name : {"mining.set_difficulty", "mining.notify"}) {
+                UniValue entry(UniValue::VARR);
+                entry.push_back(name);
+                entry.push_back(HexStr(client.extranonce1));
+                subscription.push_back(entry);
+            }
+            result = UniValue(UniValue::VARR);
+            result.push_back(subscription);
+            result.push_back(HexStr(client.extranonce1));
+            result.push_back((int)STRATUM_EXTRANONCE2_SIZE);
+            client.subscribed = true;
+            send_difficulty = send_job = true;
+        } else if (strMethod == "mining.authorize") {
+            // Any worker name is accepted, only clients from -stratumallowip can connect.
+            // A password of "d=<difficulty>" sets the worker's share difficulty
+            if (params.size() > 1 && params[1].isStr() && params[1].get_str().compare(0, 2, "d=") == 0) {
+                client.difficulty = std::max(1.0, std::min(MAX_STRATUM_DIFFICULTY, atof(params[1].get_str().c_str() + 2)));
+                send_difficulty = true;
+            }
+            client.authorized = true;
+            result = true;
+            LogPrint("stratum", "stratum: Worker %s authorized as %s\n", client.address, params.size() ? params[0].get_str() : "");
+        } else if (strMethod == "mining.suggest_difficulty") {
+            client.difficulty = std::max(1.0, std::min(MAX_STRATUM_DIFFICULTY, params[0].get_real()));
+            result = true;
+            send_difficulty = true;
+        } else if (strMethod == "mining.extranonce.subscribe") {
+            // Extranonces never change for the lifetime of a connection
+            result = true;
+        } else if (strMethod == "mining.submit") {
+            error = HandleSubmit(client, params);
+            result = error.isNull();
+        } else {
+            error = StratumError(STRATUM_OTHER, "Unknown method");
+        }
+    } catch (const std::exception& e) {
+        error = StratumError(STRATUM_OTHER, e.what());
+    }
+
+    if (!id.isNull())
+        Send(client, JSONRPCReplyObj(result, error, id));
+    if (send_difficulty)
+        SendDifficulty(client);
+    if (send_job && _jobs.Latest())
+        SendJob(client, *_jobs.Latest(), true);
+    return true;
+}
+
+UniValue StratumServer::HandleSubmit(StratumClient& client, const UniValue& params)
+{
+    if (!client.subscribed)
+        return StratumError(STRATUM_NOT_SUBSCRIBED, "Not subscribed");
+    if (!client.authorized)
+        return StratumError(STRATUM_UNAUTHORIZED, "Unauthorized worker");
+    if (params.size() < 5)
+        return StratumError(STRATUM_OTHER, "Malformed share");
+
+    const std::string& job_id = params[1].get_str();
+    const StratumJob* job = _jobs.Find(job_id);
+    if (!job)
+        return StratumError(STRATUM_JOB_NOT_FOUND, "Job not found");
+
+    const std::string& extranonce2 = params[2].get_str();
+    uint32_t ntime, nonce;
+    if (extranonce2.size() != 2 * STRATUM_EXTRANONCE2_SIZE || !IsHex(extranonce2) ||
+        !ParseHexUint32(params[3].get_str(), ntime) || !ParseHexUint32(params[4].get_str(), nonce))
+        return StratumError(STRATUM_OTHER, "Malformed share");
+    if (ntime < job->block.nTime || ntime > GetAdjustedTime() + MAX_FUTURE_BLOCK_TIME)
+        return StratumError(STRATUM_OTHER, "ntime out of range");
+    // Every share costs an Argon2d hash on the event thread, keep one worker from stalling the others
+    if (!AllowSubmit(client))
+        return StratumError(STRATUM_OTHER, "Too many shares, slow down");
+    switch (client.shares.Record(job_id, extranonce2 + params[3].get_str() + params[4].get_str())) {
+    case StratumShareLog::SHARE_DUPLICATE:
+        return StratumError(STRATUM_DUPLICATE_SHARE, "Duplicate share");
+    case StratumShareLog::SHARE_LIMIT:
+        return StratumError(STRATUM_OTHER, "Too many shares for job");
+    case StratumShareLog::SHARE_NEW:
+        break;
+    }
+
+    CBlock block;
+    if (!AssembleStratumBlock(*job, client.extranonce1, ParseHex(extranonce2), ntime, nonce, block))
+        return StratumError(STRATUM_OTHER, "Malformed share");
+    // Argon2d phase follows the submitted ntime, as for any other header
+    const uint256 hash = block.GetHash();
+
+    switch (CheckStratumShare(hash, *job, StratumShareTarget(client.difficulty, _chainparams.GetConsensus()))) {
+    case STRATUM_SHARE_BLOCK:
+        LogPrintf("stratum: Worker %s found block %s\n", client.address, hash.GetHex());
+        if (!ProcessBlockFound(block, _chainparams))
+            return StratumError(STRATUM_OTHER, "Block rejected");
+        return NullUniValue;
+    case STRATUM_SHARE_LOW:
+        return StratumError(STRATUM_LOW_DIFFICULTY, "Low difficulty share");
+    case STRATUM_SHARE_ACCEPTED:
+        break;
+    }
+    LogPrint("stratum", "stratum: Accepted share from %s, hash=%s\n", client.address, hash.GetHex());
+    return NullUniValue;
+}
+
+void StratumServer::accept_cb(struct evconnlistener* listener, evutil_socket_t fd, struct sockaddr* addr, int socklen, void* ctx)
+{
+    StratumServer* self = (StratumServer*)ctx;
+    CService service;
+    if (!service.SetSockAddr(addr) || !ClientAllowed(service)) {
+        LogPrint("stratum", "stratum: Rejected connection from %s\n", service.ToString());
+        evutil_closesocket(fd);
+        return;
+    }
+    struct bufferevent* bev = bufferevent_socket_new(self->_base, fd, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev)
+        return;
+
+    std::unique_ptr<StratumClient> client(new StratumClient());
+    client->server = self;
+    client->bev = bev;
+    client->address = service.ToString();
+    // A distinct extranonce1 per connection partitions the search space
+    const uint32_t extranonce1 = ++self->_extranonce_counter;
+    client->extranonce1.assign((const unsigned char*)&extranonce1, (const unsigned char*)&extranonce1 + STRATUM_EXTRANONCE1_SIZE);
+    client->difficulty = std::max(1.0, std::min(MAX_STRATUM_DIFFICULTY, atof(GetArg("-stratumdifficulty", std::to_string(DEFAULT_STRATUM_DIFFICULTY)).c_str())));
+
+    bufferevent_setcb(bev, readcb, NULL, eventcb, client.get());
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    LogPrint("stratum", "stratum: Worker %s connected\n", client->address);
+    self->_clients[bev] = std::move(client);
+}
+
+void StratumServer::readcb(struct bufferevent* bev, void* ctx)
+{
+    StratumClient* client = (StratumClient*)ctx;
+    struct evbuffer* input = bufferevent_get_input(bev);
+    size_t n_read_out = 0;
+    char* line;
+    while ((line = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF)) != NULL) {
+        std::string s(line, n_read_out);
+        free(line);
+        if (!client->server->HandleLine(*client, s))
+            return;
+    }
+    if (evbuffer_get_length(input) > MAX_STRATUM_LINE_LENGTH) {
+        LogPrintf("stratum: Disconnecting %s, request line too long\n", client->address);
+        client->server->Disconnect(*client);
+    }
+}
+
+void StratumServer::eventcb(struct bufferevent* bev, short what, void* ctx)
+{
+    StratumClient* client = (StratumClient*)ctx;
+    if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR))
+        client->server->Disconnect(*client);
+}
+
+void StratumServer::notify_cb(evutil_socket_t fd, short what, void* ctx)
+{
+    ((StratumServer*)ctx)->UpdateJob();
+}
+
+/****** Thread ********/
+static struct event_base* stratumBase;
+static std::unique_ptr<StratumServer> stratumServer;
+static boost::thread stratumThread;
+
+static void StratumThread()
+{
+    event_base_dispatch(stratumBase);
+}
+
+bool StartStratumServer(const CChainParams& chainparams, CConnman& connman)
+{
+    assert(!stratumBase);
+    if (!InitStratumAllowList())
+        return false;
+
+    CScript script;
+    const std::string address = GetArg("-stratumaddress", "");
+    if (!address.empty()) {
+        CTxDestination dest = DecodeDestination(address);
+        if (!IsValidDestination(dest)) {
+            LogPrintf("stratum: Invalid -stratumaddress '%s'\n", address);
+            return false;
+        }
+        script = GetScriptForDestination(dest);
+    } else {
+        std::shared_ptr<CReserveScript> coinbase_script;
+        GetMainSignals().ScriptForMining(coinbase_script);
+        if (!coinbase_script || coinbase_script->reserveScript.empty()) {
+            LogPrintf("stratum: No -stratumaddress and no wallet to pay blocks to\n");
+            return false;
+        }
+        script = coinbase_script->reserveScript;
+        coinbase_script->KeepScript();
+    }
+
+#ifdef WIN32
+    evthread_use_windows_threads();
+#else
+    evthread_use_pthreads();
+#endif
+    stratumBase = event_base_new();
+    if (!stratumBase) {
+        LogPrintf("stratum: Unable to create event_base\n");
+        return false;
+    }
+    stratumServer.reset(new StratumServer(chainparams, connman, stratumBase, script));
+    if (!stratumServer->Listen(GetArg("-stratumbind", DEFAULT_STRATUM_BIND), GetArg("-stratumport", DEFAULT_STRATUM_PORT))) {
+        stratumServer.reset();
+        event_base_free(stratumBase);
+        stratumBase = 0;
+        return false;
+    }
+
+    stratumThread = boost::thread(boost::bind(&TraceThread<void (*)()>, "stratum", &StratumThread));
+    return true;
+}
+
+void InterruptStratumServer()
+{
+    if (stratumBase) {
+        LogPrintf("stratum: Thread interrupt\n");
+        event_base_loopbreak(stratumBase);
+    }
+}
+
+void StopStratumServer()
+{
+    if (stratumBase) {
+        stratumThread.join();
+        stratumServer.reset();
+        event_base_free(stratumBase);
+        stratumBase = 0;
+    }
+}
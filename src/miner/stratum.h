@@ -0,0 +1,31 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/**
+ * Stratum v1 server for external miners.
+ */
+#ifndef CASH_MINER_STRATUM_H
+#define CASH_MINER_STRATUM_H
+
+#include <string>
+
+class CChainParams;
+class CConnman;
+
+static const bool DEFAULT_STRATUM = false;
+static const std::string DEFAULT_STRATUM_BIND = "127.0.0.1";
+static const unsigned short DEFAULT_STRATUM_PORT = 3333;
+/** Default share difficulty, relative to the chain's proof-of-work limit */
+static const double DEFAULT_STRATUM_DIFFICULTY = 1.0;
+
+/**
+ * Start the Stratum server. Jobs come from a block template pipeline of its
+ * own and are pushed to workers on every new template, solutions go through
+ * ProcessBlockFound. Returns false if it could not be started.
+ */
+bool StartStratumServer(const CChainParams& chainparams, CConnman& connman);
+void InterruptStratumServer();
+void StopStratumServer();
+
+#endif // CASH_MINER_STRATUM_H
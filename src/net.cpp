@@ -67,7 +67,7 @@
 #endif
 #endif
 
-const static std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
+const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
 constexpr const CConnman::CFullyConnectedOnly CConnman::FullyConnectedOnly;
 constexpr const CConnman::CAllNodes CConnman::AllNodes;
@@ -659,6 +659,7 @@ void CNode::copyStats(CNodeStats& stats)
     {
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgCmd);
+        X(mapProcTimePerMsgCmd);
         X(nRecvBytes);
     }
     X(fWhitelisted);
@@ -686,6 +687,16 @@ void CNode::copyStats(CNodeStats& stats)
 }
 #undef X
 
+void CNode::AccountProcessTime(const std::string& strCommand, int64_t nMicros)
+{
+    LOCK(cs_vRecv);
+    mapMsgCmdSize::iterator i = mapProcTimePerMsgCmd.find(strCommand);
+    if (i == mapProcTimePerMsgCmd.end())
+        i = mapProcTimePerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+    assert(i != mapProcTimePerMsgCmd.end());
+    i->second += nMicros;
+}
+
 bool CNode::ReceiveMsgBytes(const char* pch, unsigned int nBytes, bool& complete)
 {
     complete = false;
@@ -2743,9 +2754,12 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     fPauseSend = false;
     nProcessQueueSize = 0;
 
-    BOOST_FOREACH (const std::string& msg, getAllNetMessageTypes())
+    BOOST_FOREACH (const std::string& msg, getAllNetMessageTypes()) {
         mapRecvBytesPerMsgCmd[msg] = 0;
+        mapProcTimePerMsgCmd[msg] = 0;
+    }
     mapRecvBytesPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    mapProcTimePerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
 
     if (fLogIPs)
         LogPrint("net", "Added connection to %s peer=%d\n", addrName, id);
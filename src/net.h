@@ -609,6 +609,8 @@ struct LocalServiceInfo {
 extern CCriticalSection cs_mapLocalHost;
 extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 typedef std::map<std::string, uint64_t> mapMsgCmdSize; //command, total bytes
+/** Key used in the per-command maps for commands we do not know about */
+extern const std::string NET_MESSAGE_COMMAND_OTHER;
 
 class CNodeStats
 {
@@ -630,6 +632,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdSize mapProcTimePerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -759,6 +762,8 @@ public:
 protected:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    //! microseconds spent processing each command, guarded by cs_vRecv
+    mapMsgCmdSize mapProcTimePerMsgCmd;
 
 public:
     uint256 hashContinue;
@@ -940,6 +945,9 @@ public:
 
     void copyStats(CNodeStats& stats);
 
+    //! Account time spent in the message handler for a command received from this node
+    void AccountProcessTime(const std::string& strCommand, int64_t nMicros);
+
     ServiceFlags GetLocalServices() const
     {
         return nLocalServices;
@@ -26,6 +26,7 @@
 #include "primitives/transaction.h"
 #include "random.h"
 #include "tinyformat.h"
+#include "trace.h"
 #include "txmempool.h"
 #include "ui_interface.h"
 #include "util.h"
@@ -1301,8 +1302,91 @@ inline void static SendBlockTransactions(const CBlock& block, const BlockTransac
     connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCKTXN, resp));
 }
 
+void CMessageCost::Add(uint64_t nBytesIn, int64_t nTimeMicrosIn, int64_t nCpuMicrosIn)
+{
+    nCount++;
+    nBytes += nBytesIn;
+    nTimeMicros += nTimeMicrosIn;
+    nCpuMicros += nCpuMicrosIn;
+    nMaxMicros = std::max(nMaxMicros, nTimeMicrosIn);
+    size_t nBucket = 0;
+    while (nBucket < MSG_COST_BUCKET_COUNT - 1 && nTimeMicrosIn > MSG_COST_BUCKETS[nBucket])
+        nBucket++;
+    vHistogram[nBucket]++;
+}
+
+static CCriticalSection cs_messageCosts;
+static std::map<std::string, CMessageCost> mapMessageCosts GUARDED_BY(cs_messageCosts);
+static std::map<std::string, CMessageCost> mapHandlerCosts GUARDED_BY(cs_messageCosts);
+
+/** CPU time consumed by the calling thread, in microseconds */
+static int64_t GetThreadCpuMicros()
+{
+#ifdef WIN32
+    FILETIME ftCreation, ftExit, ftKernel, ftUser;
+    if (!GetThreadTimes(GetCurrentThread(), &ftCreation, &ftExit, &ftKernel, &ftUser))
+        return 0;
+    uint64_t nKernel = ((uint64_t)ftKernel.dwHighDateTime << 32) | ftKernel.dwLowDateTime;
+    uint64_t nUser = ((uint64_t)ftUser.dwHighDateTime << 32) | ftUser.dwLowDateTime;
+    return (nKernel + nUser) / 10;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/**
+ * Measures wall and thread CPU time of a scope and adds it to the cost map
+ * entry for strName. Unknown commands are accounted as NET_MESSAGE_COMMAND_OTHER
+ * so a peer cannot grow the maps with garbage command names.
+ */
+class CMessageCostScope
+{
+private:
+    std::map<std::string, CMessageCost>& mapCosts;
+    const std::string& strName;
+    uint64_t nBytes;
+    CNode* pnode;
+    int64_t nTimeStart;
+    int64_t nCpuStart;
+
+public:
+    CMessageCostScope(std::map<std::string, CMessageCost>& mapCostsIn, const std::string& strNameIn, uint64_t nBytesIn, CNode* pnodeIn = NULL)
+        : mapCosts(mapCostsIn), strName(strNameIn), nBytes(nBytesIn), pnode(pnodeIn)
+    {
+        nTimeStart = GetTimeMicros();
+        nCpuStart = GetThreadCpuMicros();
+    }
+
+    ~CMessageCostScope()
+    {
+        int64_t nTime = GetTimeMicros() - nTimeStart;
+        int64_t nCpu = GetThreadCpuMicros() - nCpuStart;
+        if (pnode)
+            pnode->AccountProcessTime(strName, nTime);
+        LOCK(cs_messageCosts);
+        std::map<std::string, CMessageCost>::iterator it = mapCosts.find(strName);
+        if (it == mapCosts.end()) {
+            static const std::set<std::string> setKnown(getAllNetMessageTypes().begin(), getAllNetMessageTypes().end());
+            const std::string& strKey = (&mapCosts == &mapHandlerCosts || setKnown.count(strName)) ? strName : NET_MESSAGE_COMMAND_OTHER;
+            it = mapCosts.insert(std::make_pair(strKey, CMessageCost())).first;
+        }
+        it->second.Add(nBytes, nTime, nCpu);
+    }
+};
+
+void GetMessageCosts(std::map<std::string, CMessageCost>& mapCommands, std::map<std::string, CMessageCost>& mapHandlers)
+{
+    LOCK(cs_messageCosts);
+    mapCommands = mapMessageCosts;
+    mapHandlers = mapHandlerCosts;
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
+    TRACE_SCOPE_ARG("net", "ProcessMessage", strCommand);
     LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
 
     if (IsArgSet("-dropmessagestest") && GetRand(GetArg("-dropmessagestest", 0)) == 0) {
@@ -2383,6 +2467,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Check the proof of work of the whole batch in parallel before taking
+        // cs_main. The hashes stay cached on the headers; a failing header is
+        // reported with its DoS score by ProcessNewBlockHeaders below.
+        CheckBlockHeadersProofOfWork(headers, chainparams.GetConsensus());
+
         const CBlockIndex* pindexLast = NULL;
         {
             LOCK(cs_main);
@@ -2817,15 +2906,47 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         if (found) {
             //probably one the extensions
 #ifdef ENABLE_WALLET
-            privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            {
+                static const std::string strHandler = "privatesendclient";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
 #endif // ENABLE_WALLET
-            privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            mnodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            mnpayments.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
-            masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
-            governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            {
+                static const std::string strHandler = "privatesendserver";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
+            {
+                static const std::string strHandler = "mnodeman";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                mnodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
+            {
+                static const std::string strHandler = "mnpayments";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                mnpayments.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
+            {
+                static const std::string strHandler = "instantsend";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
+            {
+                static const std::string strHandler = "spork";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
+            }
+            {
+                static const std::string strHandler = "masternodesync";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
+            }
+            {
+                static const std::string strHandler = "governance";
+                CMessageCostScope cost(mapHandlerCosts, strHandler, vRecv.size());
+                governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
+            }
         } else {
             // Ignore unknown commands for extensibility
             LogPrint("net", "Unknown command \"%s\" from peer=%d\n", SanitizeString(strCommand), pfrom->id);
@@ -2937,6 +3058,7 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
     // Process message
     bool fRet = false;
     try {
+        CMessageCostScope cost(mapMessageCosts, strCommand, nMessageSize + CMessageHeader::HEADER_SIZE, pfrom);
         fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
         if (interruptMsgProc)
             return false;
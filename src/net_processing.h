@@ -11,6 +11,10 @@
 #include "net.h"
 #include "validationinterface.h"
 
+#include <algorithm>
+#include <map>
+#include <string>
+
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 288;
 /** Expiration time for orphan transactions in seconds */
@@ -26,6 +30,27 @@ static constexpr int64_t HEADERS_DOWNLOAD_TIMEOUT_PER_HEADER = 1000;        // 1
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 288;
 
+/** Upper bounds (in microseconds) of the message processing time histogram buckets, the last bucket is open-ended */
+static const int64_t MSG_COST_BUCKETS[] = {10, 100, 1000, 10000, 100000, 1000000};
+static const size_t MSG_COST_BUCKET_COUNT = sizeof(MSG_COST_BUCKETS) / sizeof(MSG_COST_BUCKETS[0]) + 1;
+
+/** Cumulative processing cost of one message command or subsystem handler */
+struct CMessageCost {
+    uint64_t nCount;
+    uint64_t nBytes;
+    int64_t nTimeMicros;
+    int64_t nCpuMicros;
+    int64_t nMaxMicros;
+    uint64_t vHistogram[MSG_COST_BUCKET_COUNT];
+
+    CMessageCost() : nCount(0), nBytes(0), nTimeMicros(0), nCpuMicros(0), nMaxMicros(0)
+    {
+        std::fill(vHistogram, vHistogram + MSG_COST_BUCKET_COUNT, 0);
+    }
+
+    void Add(uint64_t nBytesIn, int64_t nTimeMicrosIn, int64_t nCpuMicrosIn);
+};
+
 /** Register with a network node to receive its signals */
 void RegisterNodeSignals(CNodeSignals& nodeSignals);
 /** Unregister a network node */
@@ -57,6 +82,9 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats);
 /** Increase a node's misbehavior score. */
 void Misbehaving(NodeId nodeid, int howmuch);
 
+/** Get the processing cost per message command and per subsystem handler since startup */
+void GetMessageCosts(std::map<std::string, CMessageCost>& mapCommands, std::map<std::string, CMessageCost>& mapHandlers);
+
 /** Process protocol messages received from a given node */
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interruptMsgProc);
 /**
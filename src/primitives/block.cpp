@@ -13,17 +13,15 @@
 #include "utilstrencodings.h"
 
 #include <string>
+#include <string.h>
 
-uint256 CBlockHeader::GetHash() const
+unsigned int CBlockHeader::GetHashPhase() const
 {
-    // UpdateCurrentBlockTime
-    CurrentBlockTime::UpdateCurrentBlockTime(nTime);
-
     // Get the current block time
     uint64_t currentTime = nTime;
 
     // Determine Argon2d phase
-    int hashPhase = 0;
+    unsigned int hashPhase = 0;
 
     #ifdef __APPLE__
         // On macOS we use hardcoded timestamps
@@ -41,8 +39,36 @@ uint256 CBlockHeader::GetHash() const
         }
     #endif
 
-    // Return the hash using the determined Argon2d phase
-    return hash_Argon2d(BEGIN(nVersion), END(nNonce), hashPhase);
+    return hashPhase;
+}
+
+uint256 CBlockHeader::GetHash() const
+{
+    // UpdateCurrentBlockTime
+    CurrentBlockTime::UpdateCurrentBlockTime(nTime);
+
+    // Argon2d is memory-hard, so reuse the last result while the header is unchanged
+    std::shared_ptr<const CachedHash> cached = std::atomic_load(&cachedHash);
+    if (cached && memcmp(cached->header, BEGIN(nVersion), HEADER_SIZE) == 0)
+        return cached->hash;
+
+    // Determine Argon2d phase
+    unsigned int hashPhase = GetHashPhase();
+
+    // Compute the hash using the determined Argon2d phase and remember it
+    std::shared_ptr<CachedHash> result = std::make_shared<CachedHash>();
+    memcpy(result->header, BEGIN(nVersion), HEADER_SIZE);
+    result->hash = hash_Argon2d(BEGIN(nVersion), END(nNonce), hashPhase);
+    std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>(result));
+    return result->hash;
+}
+
+void CBlockHeader::SetCachedHash(const uint256& hash) const
+{
+    std::shared_ptr<CachedHash> result = std::make_shared<CachedHash>();
+    memcpy(result->header, BEGIN(nVersion), HEADER_SIZE);
+    result->hash = hash;
+    std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>(result));
 }
 
 std::string CBlock::ToString() const
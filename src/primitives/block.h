@@ -13,6 +13,7 @@
 #include "utilstrencodings.h"
 
 #include <atomic>
+#include <memory>
 
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
@@ -37,6 +38,23 @@ public:
         SetNull();
     }
 
+    CBlockHeader(const CBlockHeader& other)
+    {
+        *this = other;
+    }
+
+    CBlockHeader& operator=(const CBlockHeader& other)
+    {
+        nVersion = other.nVersion;
+        hashPrevBlock = other.hashPrevBlock;
+        hashMerkleRoot = other.hashMerkleRoot;
+        nTime = other.nTime;
+        nBits = other.nBits;
+        nNonce = other.nNonce;
+        std::atomic_store(&cachedHash, std::atomic_load(&other.cachedHash));
+        return *this;
+    }
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -58,6 +76,7 @@ public:
         nTime = 0;
         nBits = 0;
         nNonce = 0;
+        std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>());
     }
 
     bool IsNull() const
@@ -65,12 +84,32 @@ public:
         return (nBits == 0);
     }
 
+    /** Argon2d parameter set (phase) used to hash this header, chosen by nTime */
+    unsigned int GetHashPhase() const;
+
     uint256 GetHash() const;
 
+    /** Seed the hash cache with a hash already known to belong to this exact
+     *  header (e.g. taken from the block index), skipping the Argon2d work. */
+    void SetCachedHash(const uint256& hash) const;
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
     }
+
+private:
+    static const size_t HEADER_SIZE = 80;
+
+    /** Memory only: the Argon2d hash together with the header bytes it was
+     *  computed over. Header fields are public and mutated in place (e.g. by
+     *  the miners), so the cache is only used while those bytes still match.
+     */
+    struct CachedHash {
+        unsigned char header[HEADER_SIZE];
+        uint256 hash;
+    };
+    mutable std::shared_ptr<const CachedHash> cachedHash;
 };
 
 
@@ -116,14 +155,7 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion = nVersion;
-        block.hashPrevBlock = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime = nTime;
-        block.nBits = nBits;
-        block.nNonce = nNonce;
-        return block;
+        return *this;
     }
 
     std::string ToString() const;
@@ -30,6 +30,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"setgenerate", 0, "generate"},
         {"setgenerate", 1, "genproclimit-cpu"},
         {"setgenerate", 2, "genproclimit-gpu"},
+        {"settrace", 0, "enable"},
+        {"setlockprofile", 0, "enable"},
+        {"getlockstats", 0, "count"},
+        {"getlockstats", 1, "reset"},
         {"generate", 0, "nblocks"},
         {"generate", 1, "maxtries"},
         {"generatetoaddress", 0, "nblocks"},
@@ -18,6 +18,7 @@
 #include "fluid/fluiddb.h"
 #include "fluid/fluidmint.h"
 #include "init.h"
+#include "miner/internal/miners-controller.h"
 #include "miner/miner.h"
 #include "net.h"
 #include "pow.h"
@@ -445,6 +446,91 @@ UniValue getmininginfo(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue MinerCounterStatsToJSON(const HashRateCounter::Stats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("hashespersec", stats.rate));
+    obj.push_back(Pair("hashespersec_1m", stats.rate_1m));
+    obj.push_back(Pair("hashespersec_5m", stats.rate_5m));
+    obj.push_back(Pair("hashespersec_15m", stats.rate_15m));
+    obj.push_back(Pair("hashes", stats.hashes));
+    obj.push_back(Pair("found", stats.found));
+    obj.push_back(Pair("stale", stats.stale));
+    obj.push_back(Pair("rejected", stats.rejected));
+    return obj;
+}
+
+template <class T>
+static UniValue MinerGroupStatsToJSON(const MinersThreadGroup<T>& group)
+{
+    UniValue obj = MinerCounterStatsToJSON(group.counter()->GetStats());
+    obj.push_back(Pair("threads", (int)group.size()));
+    UniValue threads(UniValue::VARR);
+    for (const auto& stats : group.counter()->GetChildStats())
+        threads.push_back(MinerCounterStatsToJSON(stats));
+    obj.push_back(Pair("thread_stats", threads));
+    return obj;
+}
+
+UniValue getminingstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getminingstats\n"
+            "\nReturns hash rate and share statistics of the integrated miner.\n"
+            "Rates are sampled every " + std::to_string(HASH_RATE_SAMPLE_INTERVAL) + " seconds, averages are exponentially weighted.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"hashespersec\": n,         (numeric) The hashes per second over the last sample interval\n"
+            "  \"hashespersec_1m\": n,      (numeric) The 1 minute average hashes per second\n"
+            "  \"hashespersec_5m\": n,      (numeric) The 5 minute average hashes per second\n"
+            "  \"hashespersec_15m\": n,     (numeric) The 15 minute average hashes per second\n"
+            "  \"hashes\": n,               (numeric) Total hashes done since start\n"
+            "  \"found\": n,                (numeric) Blocks found and accepted\n"
+            "  \"stale\": n,                (numeric) Blocks found on an outdated tip\n"
+            "  \"rejected\": n,             (numeric) Blocks found but not accepted\n"
+            "  \"devices\": {\n"
+            "    \"cpu\": {                 (object) CPU miners, same fields as above plus:\n"
+            "      \"threads\": n,          (numeric) Number of miner threads\n"
+            "      \"thread_stats\": [...]  (array) Statistics of each running miner thread\n"
+            "    },\n"
+            "    \"gpu\": {...}             (object) GPU miners, when built with GPU support\n"
+            "  },\n"
+            "  \"template\": {\n"
+            "    \"generation\": n,         (numeric) Number of block templates built\n"
+            "    \"age\": n,                (numeric) Seconds since the current template was built\n"
+            "    \"age_histogram\": {...}   (object) Lifetimes of replaced templates, keyed by upper bound in seconds\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getminingstats", "") + HelpExampleRpc("getminingstats", ""));
+
+    if (!gMiners)
+        throw JSONRPCError(RPC_MISC_ERROR, "Miner was not started (see setgenerate)");
+
+    UniValue obj = MinerCounterStatsToJSON(gMiners->counter()->GetStats());
+    UniValue devices(UniValue::VOBJ);
+    devices.push_back(Pair("cpu", MinerGroupStatsToJSON(gMiners->group_cpu())));
+#ifdef ENABLE_GPU
+    devices.push_back(Pair("gpu", MinerGroupStatsToJSON(gMiners->group_gpu())));
+#endif // ENABLE_GPU
+    obj.push_back(Pair("devices", devices));
+
+    MinerSharedContextRef shared = gMiners->shared();
+    UniValue block_template(UniValue::VOBJ);
+    block_template.push_back(Pair("generation", (uint64_t)shared->generation()));
+    block_template.push_back(Pair("age", shared->template_age()));
+    UniValue histogram(UniValue::VOBJ);
+    std::vector<uint64_t> ages = shared->template_age_histogram();
+    for (size_t i = 0; i < ages.size(); i++) {
+        const std::string bound = i + 1 < ages.size() ? std::to_string(MINER_TEMPLATE_AGE_BUCKETS[i]) : "inf";
+        histogram.push_back(Pair(bound, ages[i]));
+    }
+    block_template.push_back(Pair("age_histogram", histogram));
+    obj.push_back(Pair("template", block_template));
+    return obj;
+}
+
 
 // NOTE: Unlike wallet RPC (which use BTC values), mining RPCs follow GBT (BIP 22) in using satoshi amounts
 UniValue prioritisetransaction(const JSONRPCRequest& request)
@@ -1159,6 +1245,7 @@ static const CRPCCommand commands[] =
         //  --------------------- ------------------------  -----------------------  ------ ---
         {"mining", "getnetworkhashps", &getnetworkhashps, true, {"nblocks", "height"}},
         {"mining", "getmininginfo", &getmininginfo, true, {}},
+        {"mining", "getminingstats", &getminingstats, true, {}},
         {"mining", "prioritisetransaction", &prioritisetransaction, true, {"txid", "priority_delta", "fee_delta"}},
         {"mining", "getblocktemplate", &getblocktemplate, true, {"template_request"}},
         {"mining", "submitblock", &submitblock, true, {"hexdata", "parameters"}},
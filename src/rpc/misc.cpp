@@ -7,6 +7,7 @@
 
 #include "base58.h"
 #include "clientversion.h"
+#include "dbwrapper.h"
 #include "masternode-sync.h"
 #include "init.h"
 #include "net.h"
@@ -14,6 +15,7 @@
 #include "rpc/server.h"
 #include "spork.h"
 #include "timedata.h"
+#include "trace.h"
 #include "txmempool.h"
 #include "util.h"
 #include "utilstrencodings.h"
@@ -28,6 +30,7 @@
 #include <stdint.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/assign/list_of.hpp>
 
 class CSporkManager;
@@ -137,10 +140,139 @@ UniValue debug(const JSONRPCRequest& request)
     ForceSetArg("-debug", newMultiArgs[newMultiArgs.size() - 1]);
 
     fDebug = GetArg("-debug", "") != "0";
+    UpdateLogCategories();
 
     return "Debug mode: " + (fDebug ? strMode : "off");
 }
 
+UniValue settrace(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "settrace enable\n"
+            "Turn recording of hot path timings (see -trace) on or off.\n"
+            "\nArguments:\n"
+            "1. enable    (boolean, required) true to start recording, false to stop\n"
+            "\nExamples:\n" +
+            HelpExampleCli("settrace", "true") + HelpExampleRpc("settrace", "true"));
+
+    TraceSetEnabled(request.params[0].get_bool());
+    return NullUniValue;
+}
+
+UniValue dumptrace(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptrace \"filename\"\n"
+            "Write the recorded hot path timings (see -trace and settrace) to a Chrome trace file,\n"
+            "viewable in chrome://tracing or Perfetto. The most recent -tracebuffer events of every thread are kept.\n"
+            "\nArguments:\n"
+            "1. \"filename\"    (string, required) The file to write, relative to the data directory unless absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filename\": \"xxx\",   (string) The full path of the written file\n"
+            "  \"events\": n,          (numeric) Number of events written\n"
+            "  \"enabled\": true|false (boolean) Whether recording is on\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("dumptrace", "\"trace.json\"") + HelpExampleRpc("dumptrace", "\"trace.json\""));
+
+    boost::filesystem::path path = boost::filesystem::absolute(request.params[0].get_str(), GetDataDir());
+    std::string strError;
+    int64_t nEvents = TraceWriteChromeJSON(path.string(), strError);
+    if (nEvents < 0)
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("filename", path.string()));
+    obj.push_back(Pair("events", nEvents));
+    obj.push_back(Pair("enabled", fTraceEnabled.load()));
+    return obj;
+}
+
+UniValue setlockprofile(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "setlockprofile enable\n"
+            "Turn recording of lock wait and hold times (see -lockprofile) on or off.\n"
+            "Only available in builds configured with --enable-lockprofile.\n"
+            "\nArguments:\n"
+            "1. enable    (boolean, required) true to start recording, false to stop\n"
+            "\nExamples:\n" +
+            HelpExampleCli("setlockprofile", "true") + HelpExampleRpc("setlockprofile", "true"));
+
+    if (!SetLockProfileEnabled(request.params[0].get_bool()))
+        throw JSONRPCError(RPC_MISC_ERROR, "Lock profiling is not available, configure with --enable-lockprofile");
+    return NullUniValue;
+}
+
+UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getlockstats ( count reset )\n"
+            "Returns per lock site (LOCK invocation) acquisition counts and wait and hold times\n"
+            "recorded since startup or the last reset, sorted by total wait time.\n"
+            "Only available in builds configured with --enable-lockprofile, see also setlockprofile.\n"
+            "\nArguments:\n"
+            "1. count    (numeric, optional, default=50) Number of sites to return, 0 for all\n"
+            "2. reset    (boolean, optional, default=false) Reset all counters after reading them\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"lock\": \"name\",       (string) The locked expression, e.g. cs_main\n"
+            "    \"site\": \"file:line\",  (string) Where it was locked\n"
+            "    \"acquisitions\": n,    (numeric) Number of times the lock was taken\n"
+            "    \"contentions\": n,     (numeric) Number of times the lock was not free\n"
+            "    \"wait_us\": n,         (numeric) Total time spent waiting, in microseconds\n"
+            "    \"max_wait_us\": n,     (numeric) Longest wait, in microseconds\n"
+            "    \"hold_us\": n,         (numeric) Total time the lock was held, in microseconds\n"
+            "    \"max_hold_us\": n      (numeric) Longest hold, in microseconds\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getlockstats", "") + HelpExampleCli("getlockstats", "10 true") + HelpExampleRpc("getlockstats", "10, true"));
+
+    size_t nCount = 50;
+    if (request.params.size() > 0) {
+        int64_t n = request.params[0].get_int64();
+        if (n < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "count must be non-negative");
+        nCount = n;
+    }
+    bool fReset = request.params.size() > 1 && request.params[1].get_bool();
+
+    std::vector<CLockSiteStats> vStats;
+    if (!GetLockProfile(vStats))
+        throw JSONRPCError(RPC_MISC_ERROR, "Lock profiling is not available, configure with --enable-lockprofile");
+    if (fReset)
+        ResetLockProfile();
+
+    std::sort(vStats.begin(), vStats.end(), [](const CLockSiteStats& a, const CLockSiteStats& b) {
+        return a.nWaitMicros != b.nWaitMicros ? a.nWaitMicros > b.nWaitMicros : a.nHoldMicros > b.nHoldMicros;
+    });
+    if (nCount > 0 && vStats.size() > nCount)
+        vStats.resize(nCount);
+
+    UniValue ret(UniValue::VARR);
+    for (const CLockSiteStats& stats : vStats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("lock", stats.strName));
+        obj.push_back(Pair("site", strprintf("%s:%d", stats.strFile, stats.nLine)));
+        obj.push_back(Pair("acquisitions", stats.nAcquisitions));
+        obj.push_back(Pair("contentions", stats.nContentions));
+        obj.push_back(Pair("wait_us", stats.nWaitMicros));
+        obj.push_back(Pair("max_wait_us", stats.nMaxWaitMicros));
+        obj.push_back(Pair("hold_us", stats.nHoldMicros));
+        obj.push_back(Pair("max_hold_us", stats.nMaxHoldMicros));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 UniValue mnsync(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1080,12 +1212,14 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
-            "  }\n"
+            "  },\n"
+            "  \"dbblockcache\": xxxxx,    (numeric) Number of bytes in the database block cache shared by all databases\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getmemoryinfo", "") + HelpExampleRpc("getmemoryinfo", ""));
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+    obj.push_back(Pair("dbblockcache", (uint64_t)GetSharedDBCacheUsage()));
     return obj;
 }
 
@@ -1108,6 +1242,10 @@ static const CRPCCommand commands[] =
         {"control", "debug", &debug, true, {}},
         {"control", "getinfo", &getinfo, true, {}}, /* uses wallet if enabled */
         {"control", "getmemoryinfo", &getmemoryinfo, true, {}},
+        {"control", "settrace", &settrace, true, {"enable"}},
+        {"control", "dumptrace", &dumptrace, true, {"filename"}},
+        {"control", "setlockprofile", &setlockprofile, true, {"enable"}},
+        {"control", "getlockstats", &getlockstats, true, {"count", "reset"}},
 
         {"util", "validateaddress", &validateaddress, true, {"address"}}, /* uses wallet if enabled */
         {"util", "createmultisig", &createmultisig, true, {"nrequired", "keys"}},
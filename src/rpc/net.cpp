@@ -104,6 +104,10 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "       \"addr\": n,             (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
             "    }\n"
+            "    \"proctime_per_msg\": {\n"
+            "       \"addr\": n,             (numeric) The total microseconds spent processing messages, aggregated by message type\n"
+            "       ...\n"
+            "    }\n"
             "  }\n"
             "  ,...\n"
             "]\n"
@@ -173,6 +177,13 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.push_back(Pair("bytesrecv_per_msg", recvPerMsgCmd));
 
+        UniValue procPerMsgCmd(UniValue::VOBJ);
+        BOOST_FOREACH (const mapMsgCmdSize::value_type& i, stats.mapProcTimePerMsgCmd) {
+            if (i.second > 0)
+                procPerMsgCmd.push_back(Pair(i.first, i.second));
+        }
+        obj.push_back(Pair("proctime_per_msg", procPerMsgCmd));
+
         ret.push_back(obj);
     }
 
@@ -348,6 +359,106 @@ UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue MessageCostToJSON(const CMessageCost& cost)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("count", cost.nCount));
+    obj.push_back(Pair("bytes", cost.nBytes));
+    obj.push_back(Pair("time_us", cost.nTimeMicros));
+    obj.push_back(Pair("cpu_us", cost.nCpuMicros));
+    obj.push_back(Pair("max_us", cost.nMaxMicros));
+    UniValue histogram(UniValue::VOBJ);
+    for (size_t i = 0; i < MSG_COST_BUCKET_COUNT; i++)
+        histogram.push_back(Pair(i < MSG_COST_BUCKET_COUNT - 1 ? strprintf("%d", MSG_COST_BUCKETS[i]) : "inf", cost.vHistogram[i]));
+    obj.push_back(Pair("histogram", histogram));
+    return obj;
+}
+
+static void MessageCostsToPrometheus(std::string& strOut, const std::string& strMetric, const std::string& strLabel, const std::map<std::string, CMessageCost>& mapCosts)
+{
+    strOut += strprintf("# TYPE %s_count_total counter\n", strMetric);
+    for (const auto& entry : mapCosts)
+        strOut += strprintf("%s_count_total{%s=\"%s\"} %u\n", strMetric, strLabel, entry.first, entry.second.nCount);
+    strOut += strprintf("# TYPE %s_bytes_total counter\n", strMetric);
+    for (const auto& entry : mapCosts)
+        strOut += strprintf("%s_bytes_total{%s=\"%s\"} %u\n", strMetric, strLabel, entry.first, entry.second.nBytes);
+    strOut += strprintf("# TYPE %s_cpu_seconds_total counter\n", strMetric);
+    for (const auto& entry : mapCosts)
+        strOut += strprintf("%s_cpu_seconds_total{%s=\"%s\"} %.6f\n", strMetric, strLabel, entry.first, entry.second.nCpuMicros / 1e6);
+    strOut += strprintf("# TYPE %s_duration_seconds histogram\n", strMetric);
+    for (const auto& entry : mapCosts) {
+        uint64_t nCumulative = 0;
+        for (size_t i = 0; i < MSG_COST_BUCKET_COUNT; i++) {
+            nCumulative += entry.second.vHistogram[i];
+            std::string strBound = i < MSG_COST_BUCKET_COUNT - 1 ? strprintf("%g", MSG_COST_BUCKETS[i] / 1e6) : "+Inf";
+            strOut += strprintf("%s_duration_seconds_bucket{%s=\"%s\",le=\"%s\"} %u\n", strMetric, strLabel, entry.first, strBound, nCumulative);
+        }
+        strOut += strprintf("%s_duration_seconds_sum{%s=\"%s\"} %.6f\n", strMetric, strLabel, entry.first, entry.second.nTimeMicros / 1e6);
+        strOut += strprintf("%s_duration_seconds_count{%s=\"%s\"} %u\n", strMetric, strLabel, entry.first, entry.second.nCount);
+    }
+}
+
+UniValue getmessagestats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getmessagestats ( \"format\" )\n"
+            "\nReturns the time spent in the message handler thread since startup, per P2P command\n"
+            "and per subsystem handler (masternodes, governance, instantsend, ...).\n"
+            "Command times include the time spent in the subsystem handlers they were passed to.\n"
+            "\nArguments:\n"
+            "1. \"format\"     (string, optional, default=\"json\") \"json\" or \"prometheus\" for the text exposition format\n"
+            "\nResult (json format):\n"
+            "{\n"
+            "  \"commands\": {\n"
+            "    \"command\": {\n"
+            "      \"count\": n,      (numeric) Number of messages processed\n"
+            "      \"bytes\": n,      (numeric) Total bytes of these messages, including headers\n"
+            "      \"time_us\": n,    (numeric) Total wall clock time in microseconds\n"
+            "      \"cpu_us\": n,     (numeric) Total thread CPU time in microseconds\n"
+            "      \"max_us\": n,     (numeric) Longest single processing time in microseconds\n"
+            "      \"histogram\": {   (json object) Message count by processing time upper bound in microseconds\n"
+            "        \"10\": n,\n"
+            "        ...\n"
+            "        \"inf\": n\n"
+            "      }\n"
+            "    },\n"
+            "    ...\n"
+            "  },\n"
+            "  \"handlers\": {    (json object) Same fields, per subsystem handler\n"
+            "    ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getmessagestats", "") + HelpExampleCli("getmessagestats", "prometheus") + HelpExampleRpc("getmessagestats", "\"json\""));
+
+    std::string strFormat = request.params.size() > 0 ? request.params[0].get_str() : "json";
+    if (strFormat != "json" && strFormat != "prometheus")
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid format, must be json or prometheus");
+
+    std::map<std::string, CMessageCost> mapCommands, mapHandlers;
+    GetMessageCosts(mapCommands, mapHandlers);
+
+    if (strFormat == "prometheus") {
+        std::string strOut;
+        MessageCostsToPrometheus(strOut, "cash_p2p_message", "command", mapCommands);
+        MessageCostsToPrometheus(strOut, "cash_p2p_handler", "handler", mapHandlers);
+        return strOut;
+    }
+
+    UniValue commands(UniValue::VOBJ);
+    for (const auto& entry : mapCommands)
+        commands.push_back(Pair(entry.first, MessageCostToJSON(entry.second)));
+    UniValue handlers(UniValue::VOBJ);
+    for (const auto& entry : mapHandlers)
+        handlers.push_back(Pair(entry.first, MessageCostToJSON(entry.second)));
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("commands", commands));
+    obj.push_back(Pair("handlers", handlers));
+    return obj;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -601,6 +712,7 @@ static const CRPCCommand commands[] =
         {"network", "disconnectnode", &disconnectnode, true, {"address"}},
         {"network", "getaddednodeinfo", &getaddednodeinfo, true, {"node"}},
         {"network", "getnettotals", &getnettotals, true, {}},
+        {"network", "getmessagestats", &getmessagestats, true, {"format"}},
         {"network", "getnetworkinfo", &getnetworkinfo, true, {}},
         {"network", "setban", &setban, true, {"subnet", "command", "bantime", "absolute"}},
         {"network", "listbanned", &listbanned, true, {}},
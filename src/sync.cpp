@@ -11,9 +11,13 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <set>
+#include <tuple>
+#include <unordered_map>
 
 #ifdef DEBUG_LOCKCONTENTION
 #if !defined(HAVE_THREAD_LOCAL)
@@ -26,6 +30,147 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+#ifdef DEBUG_LOCKPROFILE
+//
+// Lock contention profiling.
+// Every LOCK site (name, file and line) gets a record of atomic counters that
+// is never freed, so the lock wrappers can keep a raw pointer to it. Threads
+// cache the site lookup so the global map is only locked the first time a
+// thread passes a site.
+//
+
+std::atomic<bool> g_lockprofile_enabled(false);
+
+struct CLockSite {
+    const std::string strName;
+    const std::string strFile;
+    const int nLine;
+    std::atomic<uint64_t> nAcquisitions;
+    std::atomic<uint64_t> nContentions;
+    std::atomic<int64_t> nWaitMicros;
+    std::atomic<int64_t> nMaxWaitMicros;
+    std::atomic<int64_t> nHoldMicros;
+    std::atomic<int64_t> nMaxHoldMicros;
+
+    CLockSite(const char* pszName, const char* pszFile, int nLineIn)
+        : strName(pszName), strFile(pszFile), nLine(nLineIn), nAcquisitions(0), nContentions(0),
+          nWaitMicros(0), nMaxWaitMicros(0), nHoldMicros(0), nMaxHoldMicros(0) {}
+
+    void Reset()
+    {
+        nAcquisitions = 0;
+        nContentions = 0;
+        nWaitMicros = 0;
+        nMaxWaitMicros = 0;
+        nHoldMicros = 0;
+        nMaxHoldMicros = 0;
+    }
+};
+
+struct LockSiteKeyHash {
+    size_t operator()(const std::tuple<const char*, const char*, int>& key) const
+    {
+        return std::hash<const void*>()(std::get<0>(key)) ^ (std::hash<const void*>()(std::get<1>(key)) << 1) ^ std::get<2>(key);
+    }
+};
+
+// Intentionally leaked: locks taken from static destructors may still use them
+static std::mutex& cs_locksites = *new std::mutex();
+static std::map<std::tuple<std::string, std::string, int>, std::unique_ptr<CLockSite> >& mapLockSites = *new std::map<std::tuple<std::string, std::string, int>, std::unique_ptr<CLockSite> >();
+static thread_local std::unordered_map<std::tuple<const char*, const char*, int>, CLockSite*, LockSiteKeyHash> g_locksite_cache;
+
+static void UpdateMax(std::atomic<int64_t>& nMax, int64_t nValue)
+{
+    int64_t nPrev = nMax.load(std::memory_order_relaxed);
+    while (nValue > nPrev && !nMax.compare_exchange_weak(nPrev, nValue, std::memory_order_relaxed)) {
+    }
+}
+
+CLockSite* LockProfileSite(const char* pszName, const char* pszFile, int nLine)
+{
+    std::tuple<const char*, const char*, int> key(pszName, pszFile, nLine);
+    auto it = g_locksite_cache.find(key);
+    if (it != g_locksite_cache.end())
+        return it->second;
+
+    // The same site can reach us with different string addresses from
+    // different translation units (LOCK in inline functions), merge them here.
+    std::lock_guard<std::mutex> lock(cs_locksites);
+    std::unique_ptr<CLockSite>& site = mapLockSites[std::make_tuple(std::string(pszName), std::string(pszFile), nLine)];
+    if (!site)
+        site.reset(new CLockSite(pszName, pszFile, nLine));
+    g_locksite_cache.emplace(key, site.get());
+    return site.get();
+}
+
+int64_t LockProfileNow()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LockProfileAcquired(CLockSite* site, bool fContended, int64_t nWaitMicros)
+{
+    site->nAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (fContended) {
+        site->nContentions.fetch_add(1, std::memory_order_relaxed);
+        site->nWaitMicros.fetch_add(nWaitMicros, std::memory_order_relaxed);
+        UpdateMax(site->nMaxWaitMicros, nWaitMicros);
+    }
+}
+
+void LockProfileReleased(CLockSite* site, int64_t nHoldMicros)
+{
+    site->nHoldMicros.fetch_add(nHoldMicros, std::memory_order_relaxed);
+    UpdateMax(site->nMaxHoldMicros, nHoldMicros);
+}
+
+bool LockProfileAvailable()
+{
+    return true;
+}
+
+bool SetLockProfileEnabled(bool fEnabled)
+{
+    g_lockprofile_enabled = fEnabled;
+    return true;
+}
+
+bool GetLockProfile(std::vector<CLockSiteStats>& vStats)
+{
+    vStats.clear();
+    std::lock_guard<std::mutex> lock(cs_locksites);
+    for (const auto& entry : mapLockSites) {
+        const CLockSite& site = *entry.second;
+        if (site.nAcquisitions == 0)
+            continue;
+        CLockSiteStats stats;
+        stats.strName = site.strName;
+        stats.strFile = site.strFile;
+        stats.nLine = site.nLine;
+        stats.nAcquisitions = site.nAcquisitions;
+        stats.nContentions = site.nContentions;
+        stats.nWaitMicros = site.nWaitMicros;
+        stats.nMaxWaitMicros = site.nMaxWaitMicros;
+        stats.nHoldMicros = site.nHoldMicros;
+        stats.nMaxHoldMicros = site.nMaxHoldMicros;
+        vStats.push_back(stats);
+    }
+    return true;
+}
+
+void ResetLockProfile()
+{
+    std::lock_guard<std::mutex> lock(cs_locksites);
+    for (auto& entry : mapLockSites)
+        entry.second->Reset();
+}
+#else
+bool LockProfileAvailable() { return false; }
+bool SetLockProfileEnabled(bool fEnabled) { return false; }
+bool GetLockProfile(std::vector<CLockSiteStats>& vStats) { return false; }
+void ResetLockProfile() {}
+#endif /* DEBUG_LOCKPROFILE */
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -9,9 +9,13 @@
 
 #include <threadsafety.h>
 
+#include <atomic>
 #include <condition_variable>
+#include <stdint.h>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 
 ////////////////////////////////////////////////
@@ -117,14 +121,69 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/** Default for -lockprofile, only used in builds configured with --enable-lockprofile */
+static const bool DEFAULT_LOCKPROFILE = false;
+
+/** Contention statistics of one lock site (LOCK macro invocation) */
+struct CLockSiteStats {
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    uint64_t nAcquisitions;
+    uint64_t nContentions;
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+};
+
+#ifdef DEBUG_LOCKPROFILE
+struct CLockSite;
+extern std::atomic<bool> g_lockprofile_enabled;
+CLockSite* LockProfileSite(const char* pszName, const char* pszFile, int nLine);
+int64_t LockProfileNow();
+void LockProfileAcquired(CLockSite* site, bool fContended, int64_t nWaitMicros);
+void LockProfileReleased(CLockSite* site, int64_t nHoldMicros);
+#endif
+
+/**
+ * Lock profiling is only available in builds configured with
+ * --enable-lockprofile; these return false otherwise.
+ */
+bool LockProfileAvailable();
+bool SetLockProfileEnabled(bool fEnabled);
+/** Get per-site statistics collected since startup or the last reset */
+bool GetLockProfile(std::vector<CLockSiteStats>& vStats);
+void ResetLockProfile();
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
 {
 private:
+#ifdef DEBUG_LOCKPROFILE
+    CLockSite* profileSite = nullptr;
+    int64_t nProfileAcquired = 0;
+#endif
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()));
+#ifdef DEBUG_LOCKPROFILE
+        if (g_lockprofile_enabled.load(std::memory_order_relaxed)) {
+            profileSite = LockProfileSite(pszName, pszFile, nLine);
+            if (Base::try_lock()) {
+                nProfileAcquired = LockProfileNow();
+                LockProfileAcquired(profileSite, false, 0);
+            } else {
+                int64_t nWaitStart = LockProfileNow();
+                Base::lock();
+                nProfileAcquired = LockProfileNow();
+                LockProfileAcquired(profileSite, true, nProfileAcquired - nWaitStart);
+            }
+            return;
+        }
+#endif
 #ifdef DEBUG_LOCKCONTENTION
         bool locked = Base::try_lock();
         if (!locked) {
@@ -145,6 +204,13 @@ private:
         if (!locked) {
             LeaveCritical(); // Leave critical section if lock was not acquired
         }
+#ifdef DEBUG_LOCKPROFILE
+        else if (g_lockprofile_enabled.load(std::memory_order_relaxed)) {
+            profileSite = LockProfileSite(pszName, pszFile, nLine);
+            nProfileAcquired = LockProfileNow();
+            LockProfileAcquired(profileSite, false, 0);
+        }
+#endif
         return locked;
     }
 
@@ -170,8 +236,16 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+#ifdef DEBUG_LOCKPROFILE
+            // Includes time the lock was temporarily released (condition
+            // variable waits, reverse_lock); locks unlocked by hand before
+            // going out of scope are not accounted
+            if (profileSite)
+                LockProfileReleased(profileSite, LockProfileNow() - nProfileAcquired);
+#endif
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -0,0 +1,156 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "arenamap.h"
+
+#include "memusage.h"
+#include "test/test_cash.h"
+
+#include <map>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+// Deliberately weak hash so that long probe sequences and wrap-around are exercised.
+struct WeakHasher {
+    size_t operator()(uint32_t k) const { return k % 97; }
+};
+
+typedef arenamap<uint32_t, std::string, WeakHasher> TestMap;
+
+void CheckEqual(const TestMap& map, const std::map<uint32_t, std::string>& ref)
+{
+    BOOST_CHECK_EQUAL(map.size(), ref.size());
+    size_t count = 0;
+    for (TestMap::const_iterator it = map.begin(); it != map.end(); ++it) {
+        auto itRef = ref.find(it->first);
+        BOOST_CHECK(itRef != ref.end() && itRef->second == it->second);
+        ++count;
+    }
+    BOOST_CHECK_EQUAL(count, ref.size());
+    for (const auto& item : ref) {
+        TestMap::const_iterator it = map.find(item.first);
+        BOOST_CHECK(it != map.end() && it->second == item.second);
+    }
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(arenamap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(arenamap_random_operations)
+{
+    TestMap map;
+    std::map<uint32_t, std::string> ref;
+    for (int i = 0; i < 20000; i++) {
+        uint32_t key = InsecureRandRange(2000);
+        switch (InsecureRandRange(4)) {
+        case 0:
+        case 1: {
+            std::string value = std::to_string(InsecureRand32());
+            auto ret = map.try_emplace(key, value);
+            bool fInserted = ref.emplace(key, value).second;
+            BOOST_CHECK_EQUAL(ret.second, fInserted);
+            BOOST_CHECK(ret.first->second == ref[key]);
+            break;
+        }
+        case 2:
+            map[key] = "overwritten";
+            ref[key] = "overwritten";
+            break;
+        case 3:
+            BOOST_CHECK_EQUAL(map.erase(key), ref.erase(key));
+            break;
+        }
+        if (i % 1000 == 0)
+            CheckEqual(map, ref);
+    }
+    CheckEqual(map, ref);
+}
+
+BOOST_AUTO_TEST_CASE(arenamap_erase_while_iterating)
+{
+    TestMap map;
+    for (uint32_t i = 0; i < 1000; i++)
+        map.try_emplace(i, std::to_string(i));
+    // References stay valid while the map grows.
+    const std::string& first = map.find(0)->second;
+    for (uint32_t i = 1000; i < 5000; i++)
+        map.try_emplace(i, std::to_string(i));
+    BOOST_CHECK(first == "0");
+
+    size_t nVisited = 0;
+    for (TestMap::iterator it = map.begin(); it != map.end();) {
+        if (it->first % 2)
+            map.erase(it++);
+        else
+            ++it;
+        ++nVisited;
+    }
+    BOOST_CHECK_EQUAL(nVisited, 5000U);
+    BOOST_CHECK_EQUAL(map.size(), 2500U);
+    for (uint32_t i = 0; i < 5000; i++)
+        BOOST_CHECK_EQUAL(map.count(i), i % 2 ? 0U : 1U);
+
+    // Erased slots are reused before the arena grows.
+    size_t nChunks = map.chunk_count();
+    for (uint32_t i = 1; i < 5000; i += 2)
+        map.try_emplace(i, std::to_string(i));
+    BOOST_CHECK_EQUAL(map.chunk_count(), nChunks);
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(arenamap_compact)
+{
+    TestMap map;
+    std::map<uint32_t, std::string> ref;
+    for (uint32_t i = 0; i < 5000; i++)
+        map.try_emplace(i, std::to_string(i));
+    const size_t nPeakUsage = memusage::DynamicUsage(map);
+    for (uint32_t i = 0; i < 5000; i++) {
+        if (i % 10)
+            map.erase(i);
+        else
+            ref[i] = std::to_string(i);
+    }
+    // Erased slots stay allocated, and are counted, until the arena is compacted.
+    BOOST_CHECK(memusage::DynamicUsage(map) >= nPeakUsage);
+    BOOST_CHECK(map.chunks_in_use() < map.chunk_count());
+
+    map.touch(map.find(10));
+    map.compact();
+    CheckEqual(map, ref);
+    BOOST_CHECK_EQUAL(map.chunk_count(), map.chunks_in_use());
+    BOOST_CHECK(memusage::DynamicUsage(map) < nPeakUsage / 4);
+
+    // Marks of recently used elements survive the move.
+    map.sweep([](const TestMap::value_type&) { return false; }, []() { return false; });
+    map.touch(map.find(10));
+    map.compact();
+    BOOST_CHECK_EQUAL(map.sweep([](const TestMap::value_type&) { return true; }, [&map]() { return map.size() <= 1; }), ref.size() - 1);
+    BOOST_CHECK_EQUAL(map.count(10), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(arenamap_sweep)
+{
+    TestMap map;
+    for (uint32_t i = 0; i < 100; i++)
+        map.try_emplace(i, std::to_string(i));
+    // Freshly inserted elements get a second chance; the first sweep only clears their marks.
+    BOOST_CHECK_EQUAL(map.sweep([](const TestMap::value_type&) { return false; }, []() { return false; }), 0U);
+
+    for (uint32_t i = 0; i < 10; i++)
+        map.touch(map.find(i));
+    size_t nErased = map.sweep([](const TestMap::value_type&) { return true; }, [&map]() { return map.size() <= 10; });
+    BOOST_CHECK_EQUAL(nErased, 90U);
+    for (uint32_t i = 0; i < 100; i++)
+        BOOST_CHECK_EQUAL(map.count(i), i < 10 ? 1U : 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
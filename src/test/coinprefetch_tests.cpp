@@ -0,0 +1,126 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "coins.h"
+#include "consensus/validation.h"
+#include "key.h"
+#include "script/interpreter.h"
+#include "test/test_cash.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** Coins cache that lets the test look at its entries */
+class CCoinsViewCacheTest : public CCoinsViewCache
+{
+public:
+    CCoinsViewCacheTest(CCoinsView* baseIn) : CCoinsViewCache(baseIn) {}
+
+    const CCoinsCacheEntry* Entry(const COutPoint& outpoint) const
+    {
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
+        return it == cacheCoins.end() ? nullptr : &it->second;
+    }
+};
+
+/** Outputs of the funding transaction, enough to make a block miss MIN_PREFETCH_COINS in the cache */
+static const uint32_t FUNDING_OUTPUTS = 100;
+/** Coins spent by each block connected in the test */
+static const uint32_t SPENT_COINS = 80;
+
+CMutableTransaction SpendCoins(const uint256& txid, uint32_t nFirst, uint32_t nCount)
+{
+    CMutableTransaction tx;
+    for (uint32_t i = nFirst; i < nFirst + nCount; i++)
+        tx.vin.push_back(CTxIn(COutPoint(txid, i)));
+    tx.vout.resize(1);
+    tx.vout[0].nValue = CENT;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    return tx;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(coinprefetch_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(coinprefetch_keeps_cached_entries)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Split a mature coinbase into coins anyone can spend.
+    CMutableTransaction txFunding;
+    txFunding.vin.resize(1);
+    txFunding.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    const CAmount nValue = coinbaseTxns[0].vout[0].nValue / (2 * FUNDING_OUTPUTS);
+    for (uint32_t i = 0; i < FUNDING_OUTPUTS; i++)
+        txFunding.vout.push_back(CTxOut(nValue, CScript() << OP_TRUE));
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(coinbaseKey.Sign(SignatureHash(scriptPubKey, txFunding, 0, SIGHASH_ALL), vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    txFunding.vin[0].scriptSig << vchSig;
+    CreateAndProcessBlock({txFunding}, scriptPubKey);
+    const uint256 txid = txFunding.GetHash();
+    BOOST_CHECK(pcoinsTip->HaveCoin(COutPoint(txid, 0)));
+
+    // Write the coins to disk and start over with an empty cache.
+    FlushStateToDisk();
+    CCoinsViewCacheTest* pcache;
+    {
+        LOCK(cs_main);
+        delete pcoinsTip;
+        pcache = new CCoinsViewCacheTest(pcoinsdbview);
+        pcoinsTip = pcache;
+    }
+
+    // The cache knows better than the database about these: a spend that
+    // wasn't written yet, and a modified coin.
+    const COutPoint outpointSpent(txid, 0);
+    const COutPoint outpointModified(txid, 1);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(pcoinsTip->SpendCoin(outpointSpent));
+        BOOST_CHECK(pcoinsTip->SpendCoin(outpointModified));
+        pcoinsTip->AddCoin(outpointModified, Coin(CTxOut(nValue + 1, CScript() << OP_TRUE), 1, false), false);
+    }
+    const uint256 hashTip = chainActive.Tip()->GetBlockHash();
+
+    // A block that spends the spent coin again must not connect, whatever the
+    // database says.
+    CreateAndProcessBlock({SpendCoins(txid, 0, SPENT_COINS)}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == hashTip);
+    {
+        LOCK(cs_main);
+        const CCoinsCacheEntry* entry = pcache->Entry(outpointSpent);
+        BOOST_REQUIRE(entry);
+        BOOST_CHECK(entry->coin.IsSpent());
+        BOOST_CHECK_EQUAL(entry->flags, CCoinsCacheEntry::DIRTY);
+        entry = pcache->Entry(outpointModified);
+        BOOST_REQUIRE(entry);
+        BOOST_CHECK_EQUAL(entry->coin.out.nValue, nValue + 1);
+        BOOST_CHECK_EQUAL(entry->flags, CCoinsCacheEntry::DIRTY);
+        // The other coins were prefetched from the database, unmodified.
+        for (uint32_t i = 2; i < SPENT_COINS; i++) {
+            entry = pcache->Entry(COutPoint(txid, i));
+            BOOST_REQUIRE(entry);
+            BOOST_CHECK(!entry->coin.IsSpent());
+            BOOST_CHECK_EQUAL(entry->coin.out.nValue, nValue);
+            BOOST_CHECK_EQUAL(entry->flags, 0);
+        }
+        BOOST_CHECK(!pcache->HaveEntryInCache(COutPoint(txid, SPENT_COINS)));
+    }
+
+    // Without the spent coin, the block connects on the prefetched ones.
+    CreateAndProcessBlock({SpendCoins(txid, 1, SPENT_COINS)}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->pprev->GetBlockHash() == hashTip);
+    {
+        LOCK(cs_main);
+        for (uint32_t i = 1; i <= SPENT_COINS; i++)
+            BOOST_CHECK(!pcoinsTip->HaveCoin(COutPoint(txid, i)));
+        BOOST_CHECK(pcoinsTip->HaveCoin(COutPoint(txid, SPENT_COINS + 1)));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
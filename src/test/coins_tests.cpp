@@ -857,4 +857,79 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_snapshot_evict)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 110; i++)
+        outpoints.emplace_back(GetRandHash(), i);
+    for (uint32_t i = 0; i < 100; i++) {
+        Coin coin;
+        SetCoinsValue(VALUE1, coin);
+        cache.AddCoin(outpoints[i], std::move(coin), false);
+    }
+    BOOST_CHECK(cache.Flush());
+    for (uint32_t i = 0; i < 100; i++)
+        BOOST_CHECK(cache.HaveCoin(outpoints[i]));
+
+    // Spend ten loaded coins and add ten new ones.
+    for (uint32_t i = 0; i < 10; i++)
+        BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+    for (uint32_t i = 100; i < 110; i++) {
+        Coin coin;
+        SetCoinsValue(VALUE2, coin);
+        cache.AddCoin(outpoints[i], std::move(coin), false);
+    }
+    // Only unmodified coins can be evicted.
+    cache.EvictClean(0);
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 20U);
+
+    CCoinsMap mapCoins;
+    cache.SnapshotDirty(mapCoins);
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(mapCoins.size(), 20U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 20U);
+    for (const auto& entry : mapCoins)
+        BOOST_CHECK_EQUAL(entry.second.flags, DIRTY);
+    for (const auto& entry : cache.map())
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    // The spent coins are still answered from the cache before the base view has seen the write.
+    for (uint32_t i = 0; i < 10; i++)
+        BOOST_CHECK(!cache.HaveCoin(outpoints[i]));
+
+    BOOST_CHECK(base.BatchWrite(mapCoins, uint256()));
+    cache.EvictClean(0);
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    // The arena holding the evicted coins is released too.
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), 0U);
+    for (uint32_t i = 0; i < 110; i++)
+        BOOST_CHECK_EQUAL(cache.HaveCoin(outpoints[i]), i >= 10);
+    BOOST_CHECK_EQUAL(cache.AccessCoin(outpoints[105]).out.nValue, VALUE2);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_cache_coin)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    COutPoint outpoint(GetRandHash(), 0);
+    Coin coin;
+    SetCoinsValue(VALUE1, coin);
+    BOOST_CHECK(!cache.HaveEntryInCache(outpoint));
+    BOOST_CHECK(cache.CacheCoin(outpoint, Coin(coin)));
+    cache.SelfTest();
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK(!cache.AccessCoin(outpoint).IsSpent());
+
+    // A prefetched coin never replaces what the cache already knows, not even a spend.
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    BOOST_CHECK(!cache.CacheCoin(outpoint, Coin(coin)));
+    cache.SelfTest();
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK(cache.HaveEntryInCache(outpoint));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
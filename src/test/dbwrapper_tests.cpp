@@ -324,6 +324,66 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    BOOST_CHECK_EQUAL(GetDBProfile("chainstate").name, "chainstate");
+    BOOST_CHECK_EQUAL(GetDBProfile("fluid-mint").name, "append");
+    BOOST_CHECK_EQUAL(GetDBProfile("index").name, "default");
+
+    std::string strDatabase;
+    const CDBProfile* profile;
+    BOOST_CHECK(ParseDBProfileArg("bdap-entries:default", strDatabase, profile));
+    BOOST_CHECK_EQUAL(strDatabase, "bdap-entries");
+    BOOST_CHECK_EQUAL(profile, FindDBProfile("default"));
+    BOOST_CHECK(!ParseDBProfileArg("bdap-entries", strDatabase, profile));
+    BOOST_CHECK(!ParseDBProfileArg(":append", strDatabase, profile));
+    BOOST_CHECK(!ParseDBProfileArg("index:fast", strDatabase, profile));
+
+    // Compressed databases read back what was written.
+    path ph = temp_directory_path() / unique_path() / "fluid-mint";
+    {
+        CDBWrapper dbw(ph, (1 << 20), true, false, false);
+        std::string strValue(1000, 'x');
+        std::string strRead;
+        BOOST_CHECK(dbw.Write('k', strValue, true));
+        BOOST_CHECK(dbw.Read('k', strRead));
+        BOOST_CHECK_EQUAL(strRead, strValue);
+    }
+
+    ForceSetMultiArgs("-dbprofile", {"index:append", "index:chainstate"});
+    BOOST_CHECK_EQUAL(GetDBProfile("index").name, "chainstate");
+    BOOST_CHECK_EQUAL(GetDBProfile("chainstate").name, "chainstate");
 
+    ForceRemoveArg("-dbprofile");
+    BOOST_CHECK_EQUAL(GetDBProfile("index").name, "default");
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_shared_cache)
+{
+    BOOST_CHECK_EQUAL(GetSharedDBCacheUsage(), 0U);
+    SetSharedDBCacheSize(1 << 20);
+    {
+        CDBWrapper dbw1(temp_directory_path() / unique_path(), (1 << 20));
+        CDBWrapper dbw2(temp_directory_path() / unique_path(), (1 << 20));
+        // The same keys in both databases don't collide in the cache.
+        for (int i = 0; i < 1000; i++) {
+            BOOST_CHECK(dbw1.Write(i, std::string(100, 'a')));
+            BOOST_CHECK(dbw2.Write(i, std::string(100, 'b')));
+        }
+        dbw1.CompactRange(0, 1000);
+        dbw2.CompactRange(0, 1000);
+        std::string strRead;
+        for (int i = 0; i < 1000; i++) {
+            BOOST_CHECK(dbw1.Read(i, strRead) && strRead == std::string(100, 'a'));
+            BOOST_CHECK(dbw2.Read(i, strRead) && strRead == std::string(100, 'b'));
+        }
+        BOOST_CHECK(GetSharedDBCacheUsage() <= (1 << 20));
+
+        // Open databases keep using the cache they were opened with.
+        SetSharedDBCacheSize(0);
+        BOOST_CHECK_EQUAL(GetSharedDBCacheUsage(), 0U);
+        BOOST_CHECK(dbw1.Read(2, strRead) && strRead == std::string(100, 'a'));
+    }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,142 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "key.h"
+#include "miner/miner-util.h"
+#include "pow.h"
+#include "script/interpreter.h"
+#include "test/test_cash.h"
+#include "validation.h"
+#include "validationinterface.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** Counts chain state flushes of blocks with unverified scripts and transactions reported as disconnected */
+struct DeferredScriptsListener : public CValidationInterface {
+    int nFlushes;
+    int nUnverifiedFlushes;
+    int nDisconnectedTxs;
+
+    DeferredScriptsListener() : nFlushes(0), nUnverifiedFlushes(0), nDisconnectedTxs(0) {}
+
+    void SetBestChain(const CBlockLocator& locator) override
+    {
+        // Called by FlushStateToDisk, with cs_main held
+        nFlushes++;
+        BlockMap::iterator it = mapBlockIndex.find(locator.vHave[0]);
+        if (it == mapBlockIndex.end() || !it->second->IsValid(BLOCK_VALID_SCRIPTS))
+            nUnverifiedFlushes++;
+    }
+
+    void SyncTransaction(const CTransaction& tx, const CBlockIndex* pindex, int posInBlock) override
+    {
+        if (posInBlock == CMainSignals::SYNC_TRANSACTION_NOT_IN_BLOCK)
+            nDisconnectedTxs++;
+    }
+};
+
+/** Mine a block on pindexPrev, which doesn't have to be the tip, from a template made for the tip */
+CBlock MineBlock(const CBlock& blockTemplate, const CBlockIndex* pindexPrev, const std::vector<CMutableTransaction>& txns)
+{
+    CBlock block = blockTemplate;
+    block.hashPrevBlock = pindexPrev->GetBlockHash();
+    block.nTime = pindexPrev->GetBlockTime() + 1;
+    block.nBits = GetNextWorkRequired(pindexPrev, block, Params().GetConsensus());
+    block.vtx.resize(1);
+    for (const CMutableTransaction& tx : txns)
+        block.vtx.push_back(MakeTransactionRef(tx));
+    unsigned int nExtraNonce = 0;
+    IncrementExtraNonce(block, pindexPrev, nExtraNonce);
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, Params().GetConsensus()))
+        ++block.nNonce;
+    return block;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(deferred_scriptcheck_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(deferred_scriptcheck_bad_signature)
+{
+    const CChainParams& chainparams = Params();
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    CScript scriptOther = CScript() << ToByteVector(otherKey.GetPubKey()) << OP_CHECKSIG;
+
+    // A mature coinbase spent with a signature by the wrong key.
+    CMutableTransaction txBad;
+    txBad.vin.resize(1);
+    txBad.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    txBad.vout.resize(1);
+    txBad.vout[0].nValue = 11 * CENT;
+    txBad.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(otherKey.Sign(SignatureHash(scriptPubKey, txBad, 0, SIGHASH_ALL), vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    txBad.vin[0].scriptSig << vchSig;
+
+    CBlockIndex* pindexFork = chainActive.Tip();
+    std::unique_ptr<CBlockTemplate> pblocktemplate = CreateNewBlock(chainparams, scriptOther);
+    BOOST_REQUIRE(pblocktemplate);
+
+    // The active chain A has more work than the chain B under test, so B is stored but not connected.
+    std::vector<CMutableTransaction> noTxns;
+    CBlock blockA1 = CreateAndProcessBlock(noTxns, scriptPubKey);
+    for (int i = 1; i < 9; i++)
+        CreateAndProcessBlock(noTxns, scriptPubKey);
+    BOOST_CHECK_EQUAL(chainActive.Height(), pindexFork->nHeight + 9);
+
+    // The third block of B carries the bad signature.
+    std::vector<CBlockIndex*> vpindexB;
+    const CBlockIndex* pindexPrev = pindexFork;
+    for (int i = 0; i < 8; i++) {
+        std::vector<CMutableTransaction> txns;
+        if (i == 2)
+            txns.push_back(txBad);
+        std::shared_ptr<const CBlock> pblock = std::make_shared<const CBlock>(MineBlock(pblocktemplate->block, pindexPrev, txns));
+        BOOST_CHECK(ProcessNewBlock(chainparams, pblock, true, NULL));
+        LOCK(cs_main);
+        BOOST_REQUIRE(mapBlockIndex.count(pblock->GetHash()));
+        vpindexB.push_back(mapBlockIndex[pblock->GetHash()]);
+        pindexPrev = vpindexB.back();
+    }
+    BOOST_CHECK_EQUAL(chainActive.Height(), pindexFork->nHeight + 9);
+
+    // Switch to B as if importing blocks, with every block connection wanting to flush the chain state.
+    const int nScriptCheckDepthOld = nScriptCheckDepth;
+    const size_t nCoinCacheUsageOld = nCoinCacheUsage;
+    nScriptCheckDepth = 16;
+    nCoinCacheUsage = 0;
+    fImporting = true;
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, chainparams, mapBlockIndex[blockA1.GetHash()]));
+    }
+    DeferredScriptsListener listener;
+    RegisterValidationInterface(&listener);
+    CValidationState state;
+    BOOST_CHECK(ActivateBestChain(state, chainparams));
+    UnregisterValidationInterface(&listener);
+    fImporting = false;
+    nCoinCacheUsage = nCoinCacheUsageOld;
+    nScriptCheckDepth = nScriptCheckDepthOld;
+
+    LOCK(cs_main);
+    BOOST_CHECK(chainActive.Tip() == vpindexB[1]);
+    BOOST_CHECK(vpindexB[0]->IsValid(BLOCK_VALID_SCRIPTS));
+    BOOST_CHECK(vpindexB[1]->IsValid(BLOCK_VALID_SCRIPTS));
+    BOOST_CHECK(vpindexB[2]->nStatus & BLOCK_FAILED_VALID);
+    // The rolled back window was never announced, so it isn't reported as disconnected either.
+    BOOST_CHECK_EQUAL(listener.nDisconnectedTxs, 0);
+    BOOST_CHECK(listener.nFlushes > 0);
+    BOOST_CHECK_EQUAL(listener.nUnverifiedFlushes, 0);
+    BOOST_CHECK(!mempool.exists(txBad.GetHash()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "hash.h"
+#include "crypto/argon2d/workers.h"
 #include "utilstrencodings.h"
 #include "test/test_cash.h"
 
@@ -84,4 +85,54 @@ BOOST_AUTO_TEST_CASE(siphash)
     }*/
 }
 
+BOOST_AUTO_TEST_CASE(argon2d_kernel_dispatch)
+{
+    // Every runtime-selected fill_segment kernel must match the baseline one
+    std::vector<unsigned char> header(INPUT_BYTES);
+    for (size_t i = 0; i < header.size(); i++)
+        header[i] = (unsigned char)i;
+
+    std::vector<uint256> expected;
+    for (unsigned int phase = 0; phase < 3; phase++)
+        expected.push_back(hash_Argon2d(header.begin(), header.end(), phase));
+
+    std::string impl = argon2_select_impl();
+    BOOST_TEST_MESSAGE("Argon2d implementation: " << impl);
+    for (unsigned int phase = 0; phase < 3; phase++)
+        BOOST_CHECK(hash_Argon2d(header.begin(), header.end(), phase) == expected[phase]);
+}
+
+BOOST_AUTO_TEST_CASE(argon2d_parallel_lanes)
+{
+    // Filling the lanes on the lane workers must give the serial digest of every phase
+    std::vector<unsigned char> header(INPUT_BYTES);
+    for (size_t i = 0; i < header.size(); i++)
+        header[i] = (unsigned char)i;
+    const uint256 vectors[3] = {
+        uint256S("1349ba251beefe719819997f3c520cadd0268d680352ea61aec5c215d7b56e11"),
+        uint256S("f01593b75208f3afcd6eb2a07c0a6a2b36792f4ad5c278f863584746192c2cf6"),
+        uint256S("43285ec28fbcf7f453b9bf0467149512e243b4d6d2cb062a837e08df2d9c1796"),
+    };
+
+    Argon2dStartLaneWorkers(4);
+    BOOST_CHECK_EQUAL(Argon2dLaneThreads(), 4U);
+    for (unsigned int phase = 0; phase < 3; phase++) {
+        BOOST_CHECK(hash_Argon2d(header.begin(), header.end(), phase) == vectors[phase]);
+        for (unsigned char nonce = 1; nonce < 4; nonce++) {
+            std::vector<unsigned char> other(header);
+            other.back() = nonce;
+            const uint256 hashParallel = hash_Argon2d(other.begin(), other.end(), phase);
+            Argon2dSetThreadParallel(false);
+            BOOST_CHECK_EQUAL(Argon2dLaneThreads(), 1U);
+            BOOST_CHECK(hash_Argon2d(other.begin(), other.end(), phase) == hashParallel);
+            Argon2dSetThreadParallel(true);
+        }
+    }
+    Argon2dStopLaneWorkers();
+
+    BOOST_CHECK_EQUAL(Argon2dLaneThreads(), 1U);
+    for (unsigned int phase = 0; phase < 3; phase++)
+        BOOST_CHECK(hash_Argon2d(header.begin(), header.end(), phase) == vectors[phase]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,7 +18,9 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include "miner/impl/argon2d-scanner.h"
 #include "miner/impl/miner-gpu.h"
+#include "miner/internal/hash-rate-counter.h"
 
 #include "test/test_cash.h"
 
@@ -113,6 +115,71 @@ BOOST_AUTO_TEST_CASE(ScanNoncesGPU_check)
 }
 #endif //ENABLE_GPU
 
+BOOST_AUTO_TEST_CASE(ScanNoncesCPU_check)
+{
+    Argon2dScanner scanner(4);
+
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.hashPrevBlock = uint256S("0x1234");
+    header.nTime = 1500000000;
+    header.nBits = 0x1f00ffff;
+    header.nNonce = 0;
+
+    // Nothing passes a zero target
+    std::uint32_t result_nonce;
+    BOOST_CHECK(!scanner.scanNonces(header, 100, 0, result_nonce));
+
+    // Everything passes the maximum target, the first nonce is reported with its full hash
+    BOOST_CHECK(scanner.scanNonces(header, 100, std::numeric_limits<uint64_t>::max(), result_nonce));
+    BOOST_CHECK_EQUAL(result_nonce, 100U);
+    header.nNonce = result_nonce;
+    BOOST_CHECK(scanner.getResultHash() == header.GetHash());
+
+    // The last nonce of the range is a valid result too
+    const std::uint32_t last_nonce = std::numeric_limits<uint32_t>::max();
+    BOOST_CHECK(scanner.scanNonces(header, last_nonce, std::numeric_limits<uint64_t>::max(), result_nonce));
+    BOOST_CHECK_EQUAL(result_nonce, last_nonce);
+    header.nNonce = last_nonce;
+    BOOST_CHECK(scanner.getResultHash() == header.GetHash());
+
+    // The last nonce is found when it is the first to match within a batch
+    header.nNonce = last_nonce;
+    const std::uint64_t last_target = header.GetHash().GetUint64(3);
+    header.nNonce = last_nonce - 1;
+    const bool fBeforeLast = header.GetHash().GetUint64(3) <= last_target;
+    BOOST_CHECK(scanner.scanNonces(header, last_nonce - 1, last_target, result_nonce));
+    BOOST_CHECK_EQUAL(result_nonce, fBeforeLast ? last_nonce - 1 : last_nonce);
+}
+
+BOOST_AUTO_TEST_CASE(HashRateCounter_check)
+{
+    HashRateCounterRef root = std::make_shared<HashRateCounter>();
+    HashRateCounterRef child = root->MakeChild();
+
+    // The first sample only sets the baseline
+    root->Sample(1000);
+    child->Increment(5000);
+    child->IncrementFound();
+    child->IncrementStale();
+    root->Sample(6000);
+
+    HashRateCounter::Stats stats = root->GetStats();
+    BOOST_CHECK_EQUAL(stats.hashes, 5000);
+    BOOST_CHECK_EQUAL(stats.found, 1);
+    BOOST_CHECK_EQUAL(stats.stale, 1);
+    BOOST_CHECK_EQUAL(stats.rejected, 0);
+    BOOST_CHECK_EQUAL((int64_t)*root, 1000);
+    BOOST_CHECK_EQUAL((int64_t)*child, 1000);
+    BOOST_CHECK(stats.rate_1m > 0 && stats.rate_1m < stats.rate);
+    BOOST_CHECK_EQUAL(root->GetChildStats().size(), 1U);
+
+    // Totals of a finished thread stay with its parent
+    child.reset();
+    BOOST_CHECK_EQUAL(root->GetStats().hashes, 5000);
+    BOOST_CHECK_EQUAL(root->GetStats().found, 1);
+    BOOST_CHECK(root->GetChildStats().empty());
+}
 
 // NOTE: These tests rely on CreateNewBlock doing its own self-validation!
 BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
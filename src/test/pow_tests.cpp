@@ -94,4 +94,38 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* Test that the cached header hash follows in-place header mutation */
+BOOST_AUTO_TEST_CASE(block_header_hash_cache)
+{
+    SelectParams(CBaseChainParams::MAIN);
+
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1408732505;
+    header.nBits = 0x1b06b2f1;
+    header.nNonce = 42;
+    const uint256 hash = header.GetHash();
+    BOOST_CHECK(header.GetHash() == hash);
+
+    CBlockHeader copy(header);
+    BOOST_CHECK(copy.GetHash() == hash);
+
+    header.nNonce++;
+    const uint256 hashNext = header.GetHash();
+    BOOST_CHECK(hashNext != hash);
+    BOOST_CHECK(copy.GetHash() == hash);
+
+    header.nNonce--;
+    BOOST_CHECK(header.GetHash() == hash);
+
+    CBlock block(copy);
+    block.nNonce++;
+    BOOST_CHECK(block.GetHash() == hashNext);
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == hashNext);
+
+    block.SetNull();
+    CBlockHeader nullHeader;
+    BOOST_CHECK(block.GetHash() == nullHeader.GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
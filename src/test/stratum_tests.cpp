@@ -0,0 +1,170 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "consensus/merkle.h"
+#include "miner/internal/stratum-job.h"
+#include "streams.h"
+#include "utilstrencodings.h"
+#include "version.h"
+
+#include "test/test_cash.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** A block template with a coinbase and ntx - 1 other transactions on prev */
+CBlock MakeTemplate(const uint256& prev, size_t ntx)
+{
+    CBlock block;
+    block.nVersion = 4;
+    block.hashPrevBlock = prev;
+    block.nTime = 1600000000;
+    block.nBits = 0x207fffff;
+    for (size_t i = 0; i < ntx; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        if (i == 0)
+            tx.vin[0].prevout.SetNull();
+        else
+            tx.vin[0].prevout = COutPoint(prev, i);
+        tx.vin[0].scriptSig = CScript() << OP_0;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 50 * COIN + i;
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    return block;
+}
+
+StratumJob MakeJob(const std::string& id, const uint256& prev)
+{
+    return MakeStratumJob(id, MakeTemplate(prev, 3), 100, CScript() << OP_TRUE);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(stratum_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(stratum_coinbase_split)
+{
+    const CScript script = CScript() << OP_DUP << OP_HASH160 << ParseHex("0102030405060708090a0b0c0d0e0f1011121314") << OP_EQUALVERIFY << OP_CHECKSIG;
+    const StratumJob job = MakeStratumJob("1", MakeTemplate(uint256S("0x01"), 3), 12345, script);
+    BOOST_CHECK_EQUAL(job.height, 12345);
+
+    // coinb1 ends with the push opcode of both extranonces
+    BOOST_CHECK_EQUAL(job.coinb1.back(), STRATUM_EXTRANONCE1_SIZE + STRATUM_EXTRANONCE2_SIZE);
+
+    const std::vector<unsigned char> extranonce1 = ParseHex("a1a2a3a4");
+    const std::vector<unsigned char> extranonce2 = ParseHex("b1b2b3b4");
+    std::vector<unsigned char> data(job.coinb1);
+    data.insert(data.end(), extranonce1.begin(), extranonce1.end());
+    data.insert(data.end(), extranonce2.begin(), extranonce2.end());
+    data.insert(data.end(), job.coinb2.begin(), job.coinb2.end());
+    CMutableTransaction coinbase;
+    CDataStream ss(data, SER_NETWORK, PROTOCOL_VERSION);
+    ss >> coinbase;
+    BOOST_CHECK(ss.empty());
+
+    // The scriptSig starts with the height, then both extranonces in one push
+    const CScript expected = CScript() << 12345 << ParseHex("a1a2a3a4b1b2b3b4");
+    const CScript& scriptSig = coinbase.vin[0].scriptSig;
+    BOOST_REQUIRE(scriptSig.size() >= expected.size());
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), scriptSig.begin()));
+    BOOST_CHECK(coinbase.vout[0].scriptPubKey == script);
+    BOOST_CHECK(coinbase.vout[0].nValue == 50 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(stratum_merkle_branch)
+{
+    const std::vector<unsigned char> extranonce1 = ParseHex("00000001");
+    const std::vector<unsigned char> extranonce2 = ParseHex("deadbeef");
+    for (size_t ntx = 1; ntx <= 7; ntx++) {
+        const StratumJob job = MakeStratumJob("1", MakeTemplate(uint256S("0x02"), ntx), 200, CScript() << OP_TRUE);
+        CBlock block;
+        BOOST_REQUIRE(AssembleStratumBlock(job, extranonce1, extranonce2, job.block.nTime + 5, 42, block));
+        // The root from the branch matches the one over the full rebuilt block
+        BOOST_CHECK(block.hashMerkleRoot == BlockMerkleRoot(block));
+        BOOST_CHECK_EQUAL(block.vtx.size(), ntx);
+        for (size_t i = 1; i < ntx; i++)
+            BOOST_CHECK(block.vtx[i]->GetHash() == job.block.vtx[i]->GetHash());
+        BOOST_CHECK_EQUAL(block.nTime, job.block.nTime + 5);
+        BOOST_CHECK_EQUAL(block.nNonce, 42U);
+        BOOST_CHECK(block.hashPrevBlock == job.block.hashPrevBlock);
+    }
+
+    // Extranonces of another size don't fit the split coinbase
+    const StratumJob job = MakeJob("1", uint256S("0x02"));
+    CBlock block;
+    BOOST_CHECK(!AssembleStratumBlock(job, extranonce1, ParseHex("deadbeefff"), job.block.nTime, 0, block));
+    BOOST_CHECK(!AssembleStratumBlock(job, ParseHex("0001"), extranonce2, job.block.nTime, 0, block));
+}
+
+BOOST_AUTO_TEST_CASE(stratum_share_target)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const arith_uint256 limit = UintToArith256(params.powLimit);
+    BOOST_CHECK(StratumShareTarget(1.0, params) == limit);
+    BOOST_CHECK(StratumShareTarget(0.5, params) == limit);
+    BOOST_CHECK(StratumShareTarget(2.0, params) == (limit / 2000000) * 1000000);
+    BOOST_CHECK(StratumShareTarget(1000.0, params) < StratumShareTarget(2.0, params));
+
+    StratumJob job = MakeJob("1", uint256S("0x03"));
+    job.target = arith_uint256(1000);
+    const arith_uint256 share_target(5000);
+    BOOST_CHECK_EQUAL(CheckStratumShare(ArithToUint256(arith_uint256(1000)), job, share_target), STRATUM_SHARE_BLOCK);
+    BOOST_CHECK_EQUAL(CheckStratumShare(ArithToUint256(arith_uint256(1001)), job, share_target), STRATUM_SHARE_ACCEPTED);
+    BOOST_CHECK_EQUAL(CheckStratumShare(ArithToUint256(arith_uint256(5000)), job, share_target), STRATUM_SHARE_ACCEPTED);
+    BOOST_CHECK_EQUAL(CheckStratumShare(ArithToUint256(arith_uint256(5001)), job, share_target), STRATUM_SHARE_LOW);
+}
+
+BOOST_AUTO_TEST_CASE(stratum_stale_jobs)
+{
+    StratumJobQueue jobs;
+    BOOST_CHECK(!jobs.Latest());
+    BOOST_CHECK(jobs.Push(MakeJob("1", uint256S("0x04"))));
+    BOOST_CHECK(!jobs.Push(MakeJob("2", uint256S("0x04"))));
+    BOOST_CHECK(jobs.Find("1"));
+    BOOST_CHECK_EQUAL(jobs.Latest()->id, "2");
+
+    // Only the latest MAX_STRATUM_JOBS of a tip are kept
+    for (size_t i = 3; i <= MAX_STRATUM_JOBS + 1; i++)
+        BOOST_CHECK(!jobs.Push(MakeJob(std::to_string(i), uint256S("0x04"))));
+    BOOST_CHECK(!jobs.Find("1"));
+    BOOST_CHECK(jobs.Find("2"));
+
+    // A job on a new tip makes every older job stale
+    BOOST_CHECK(jobs.Push(MakeJob("a", uint256S("0x05"))));
+    BOOST_CHECK(!jobs.Find("2"));
+    BOOST_CHECK(!jobs.Find(std::to_string(MAX_STRATUM_JOBS + 1)));
+    BOOST_CHECK(jobs.Find("a"));
+}
+
+BOOST_AUTO_TEST_CASE(stratum_duplicate_shares)
+{
+    StratumJobQueue jobs;
+    jobs.Push(MakeJob("1", uint256S("0x06")));
+    jobs.Push(MakeJob("2", uint256S("0x06")));
+
+    StratumShareLog shares;
+    BOOST_CHECK_EQUAL(shares.Record("1", "share"), StratumShareLog::SHARE_NEW);
+    BOOST_CHECK_EQUAL(shares.Record("1", "share"), StratumShareLog::SHARE_DUPLICATE);
+    // The same solution data on another job is another share
+    BOOST_CHECK_EQUAL(shares.Record("2", "share"), StratumShareLog::SHARE_NEW);
+
+    // A job takes a bounded number of shares
+    for (size_t i = 1; i < MAX_STRATUM_SHARES_PER_JOB; i++)
+        BOOST_CHECK_EQUAL(shares.Record("2", std::to_string(i)), StratumShareLog::SHARE_NEW);
+    BOOST_CHECK_EQUAL(shares.Record("2", "one more"), StratumShareLog::SHARE_LIMIT);
+    BOOST_CHECK_EQUAL(shares.Record("2", "share"), StratumShareLog::SHARE_DUPLICATE);
+    BOOST_CHECK_EQUAL(shares.size(), MAX_STRATUM_SHARES_PER_JOB + 1);
+
+    // Shares of stale jobs are forgotten
+    jobs.Push(MakeJob("3", uint256S("0x07")));
+    shares.Prune(jobs);
+    BOOST_CHECK_EQUAL(shares.size(), 0U);
+    BOOST_CHECK_EQUAL(shares.Record("3", "share"), StratumShareLog::SHARE_NEW);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
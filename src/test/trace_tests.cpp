@@ -0,0 +1,161 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "trace.h"
+#include "util.h"
+
+#include "test/test_cash.h"
+
+#include <univalue.h>
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** Events kept per thread in these tests, small enough to wrap around */
+static const unsigned int TEST_TRACE_BUFFER = 8;
+
+void RecordEvent(const char* category, const char* name, const std::string& strArg, int64_t nStart)
+{
+    char arg[TRACE_ARG_SIZE] = {};
+    strArg.copy(arg, TRACE_ARG_SIZE - 1);
+    TraceRecord(category, name, arg, nStart, nStart + 1);
+}
+
+/** Dump all buffers and return the trace events, failing the test on invalid JSON */
+UniValue DumpTrace()
+{
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("trace_tests_%%%%%%%%.json");
+    std::string strError;
+    BOOST_CHECK(TraceWriteChromeJSON(path.string(), strError) >= 0);
+
+    std::ifstream file(path.string().c_str());
+    std::stringstream ss;
+    ss << file.rdbuf();
+    file.close();
+    boost::filesystem::remove(path);
+
+    UniValue trace;
+    BOOST_REQUIRE(trace.read(ss.str()));
+    const UniValue& events = find_value(trace, "traceEvents");
+    BOOST_REQUIRE(events.isArray());
+    return events;
+}
+
+/** Dump all buffers and return the events of the given category */
+std::vector<UniValue> DumpEvents(const std::string& category)
+{
+    const UniValue events = DumpTrace();
+    std::vector<UniValue> vEvents;
+    for (size_t i = 0; i < events.size(); i++) {
+        const UniValue& cat = find_value(events[i], "cat");
+        if (cat.isStr() && cat.get_str() == category)
+            vEvents.push_back(events[i]);
+    }
+    return vEvents;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(trace_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(trace_ring_overflow)
+{
+    TraceInit(true, TEST_TRACE_BUFFER);
+    std::thread thread([] {
+        for (int i = 0; i < 20; i++)
+            RecordEvent("test-overflow", "event", "", i);
+    });
+    thread.join();
+    TraceSetEnabled(false);
+
+    // Only the newest events of the ring are kept, in order. The oldest slot of
+    // a full ring is the next one written, so it is never dumped.
+    std::vector<UniValue> vEvents = DumpEvents("test-overflow");
+    BOOST_REQUIRE_EQUAL(vEvents.size(), TEST_TRACE_BUFFER - 1);
+    for (size_t i = 0; i < vEvents.size(); i++) {
+        BOOST_CHECK_EQUAL(find_value(vEvents[i], "ts").get_int64(), 20 - (int64_t)TEST_TRACE_BUFFER + 1 + (int64_t)i);
+        BOOST_CHECK_EQUAL(find_value(vEvents[i], "dur").get_int64(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(trace_thread_registration)
+{
+    static const int THREADS = 4;
+    static const int EVENTS = 5;
+    TraceInit(true, TEST_TRACE_BUFFER);
+
+    // All threads hold a buffer at the same time, so none can reuse another's
+    std::mutex mutex;
+    std::condition_variable cond;
+    int nRecorded = 0;
+    std::vector<std::thread> threads;
+    for (int n = 0; n < THREADS; n++) {
+        threads.emplace_back([&, n] {
+            for (int i = 0; i < EVENTS; i++)
+                RecordEvent("test-threads", "event", std::to_string(n), i);
+            std::unique_lock<std::mutex> lock(mutex);
+            nRecorded++;
+            cond.notify_all();
+            cond.wait(lock, [&] { return nRecorded == THREADS; });
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    TraceSetEnabled(false);
+
+    std::vector<UniValue> vEvents = DumpEvents("test-threads");
+    BOOST_CHECK_EQUAL(vEvents.size(), (size_t)(THREADS * EVENTS));
+    // Each thread's events land in a buffer of its own
+    std::map<std::string, std::set<int64_t> > mapThreadTids;
+    std::set<int64_t> setTids;
+    for (const UniValue& event : vEvents) {
+        const int64_t nTid = find_value(event, "tid").get_int64();
+        mapThreadTids[find_value(find_value(event, "args"), "detail").get_str()].insert(nTid);
+        setTids.insert(nTid);
+    }
+    BOOST_CHECK_EQUAL(mapThreadTids.size(), (size_t)THREADS);
+    for (const auto& thread : mapThreadTids)
+        BOOST_CHECK_EQUAL(thread.second.size(), 1U);
+    BOOST_CHECK_EQUAL(setTids.size(), (size_t)THREADS);
+}
+
+BOOST_AUTO_TEST_CASE(trace_json_escaping)
+{
+    TraceInit(true, TEST_TRACE_BUFFER);
+    std::thread thread([] {
+        RenameThread("trace\"test\\");
+        RecordEvent("test-escape", "quote\"back\\slash", "a\"b\\c\nd\te", 1);
+        // The detail is cut to TRACE_ARG_SIZE - 1 characters
+        RecordEvent("test-escape", "long", "0123456789abcdefghij", 2);
+    });
+    thread.join();
+    TraceSetEnabled(false);
+
+    const UniValue events = DumpTrace();
+    bool fThreadName = false;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (find_value(events[i], "ph").get_str() == "M" && find_value(find_value(events[i], "args"), "name").get_str() == "trace\"test\\")
+            fThreadName = true;
+    }
+    BOOST_CHECK(fThreadName);
+
+    std::vector<UniValue> vEvents = DumpEvents("test-escape");
+    BOOST_REQUIRE_EQUAL(vEvents.size(), 2U);
+    BOOST_CHECK_EQUAL(find_value(vEvents[0], "name").get_str(), "quote\"back\\slash");
+    // Control characters are replaced by spaces
+    BOOST_CHECK_EQUAL(find_value(find_value(vEvents[0], "args"), "detail").get_str(), "a\"b\\c d e");
+    BOOST_CHECK_EQUAL(find_value(find_value(vEvents[1], "args"), "detail").get_str(), std::string("0123456789abcdefghij").substr(0, TRACE_ARG_SIZE - 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
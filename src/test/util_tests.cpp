@@ -595,4 +595,50 @@ BOOST_AUTO_TEST_CASE(version_info_helper)
     BOOST_CHECK_THROW(IntVersionToString(0), std::bad_cast);
 }
 
+static int CountedLogArg(int& nCalls)
+{
+    return ++nCalls;
+}
+
+BOOST_AUTO_TEST_CASE(util_LogCategories)
+{
+    static_assert(LogCategoryIndex(NULL) == LOG_CATEGORY_ALWAYS, "LogPrintf category");
+    static_assert(LogCategoryIndex("addrman") == 0, "first category");
+    static_assert(LogCategoryIndex("zmq") == LOG_CATEGORY_COUNT - 1, "last category");
+    static_assert(LogCategoryIndex("notacategory") == LOG_CATEGORY_UNKNOWN, "unknown category");
+    for (int i = 1; i < LOG_CATEGORY_COUNT; i++)
+        BOOST_CHECK(std::string(LOG_CATEGORY_NAMES[i - 1]) < std::string(LOG_CATEGORY_NAMES[i]));
+
+    bool fDebugSaved = fDebug;
+    int nCalls = 0;
+
+    fDebug = false;
+    UpdateLogCategories();
+    BOOST_CHECK(!LogAcceptCategory("net"));
+    LogPrint("net", "%d\n", CountedLogArg(nCalls));
+    BOOST_CHECK_EQUAL(nCalls, 0);
+
+    fDebug = true;
+    ForceSetMultiArgs("-debug", std::vector<std::string>{"net", "cash", "custom"});
+    UpdateLogCategories();
+    BOOST_CHECK(LogAcceptCategory("net"));
+    BOOST_CHECK(LogAcceptCategory("masternode"));
+    BOOST_CHECK(LogAcceptCategory("custom"));
+    BOOST_CHECK(!LogAcceptCategory("mempool"));
+    BOOST_CHECK(!LogAcceptCategory("other"));
+    LogPrint("mempool", "%d\n", CountedLogArg(nCalls));
+    BOOST_CHECK_EQUAL(nCalls, 0);
+    LogPrint("net", "%d\n", CountedLogArg(nCalls));
+    BOOST_CHECK_EQUAL(nCalls, 1);
+
+    ForceSetMultiArgs("-debug", std::vector<std::string>{"1"});
+    UpdateLogCategories();
+    BOOST_CHECK(LogAcceptCategory("mempool"));
+    BOOST_CHECK(LogAcceptCategory("other"));
+
+    ForceSetMultiArgs("-debug", std::vector<std::string>());
+    fDebug = fDebugSaved;
+    UpdateLogCategories();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,186 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "trace.h"
+
+#include "tinyformat.h"
+#include "util.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> fTraceEnabled(DEFAULT_TRACE);
+
+namespace {
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    char arg[TRACE_ARG_SIZE];
+    int64_t nStart;
+    int64_t nDuration;
+};
+
+/**
+ * Single-writer ring buffer. The owning thread fills a slot and then
+ * publishes it by advancing nWritten; readers copy the published range and
+ * drop whatever the writer may have overwritten while they were copying.
+ */
+struct TraceBuffer {
+    int nThread;
+    std::string strThreadName;
+    std::vector<TraceEvent> vEvents;
+    std::atomic<uint64_t> nWritten{0};
+
+    TraceBuffer(int nThreadIn, size_t nSize) : nThread(nThreadIn), vEvents(nSize) {}
+};
+
+std::mutex csTraceBuffers;
+std::vector<std::shared_ptr<TraceBuffer> > vTraceBuffers;
+// Buffers of exited threads, reused by new threads so short-lived threads don't grow memory.
+// Their events are kept and show up under the name of the thread reusing them.
+std::vector<std::shared_ptr<TraceBuffer> > vTraceBuffersFree;
+unsigned int nTraceBufferSize = DEFAULT_TRACE_BUFFER;
+
+/** Returns the buffer to the free list when its thread exits */
+struct TraceThreadSlot {
+    std::shared_ptr<TraceBuffer> buffer;
+
+    ~TraceThreadSlot()
+    {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(csTraceBuffers);
+            vTraceBuffersFree.push_back(buffer);
+        }
+    }
+};
+
+thread_local TraceThreadSlot threadSlot;
+
+TraceBuffer* GetThreadBuffer()
+{
+    if (!threadSlot.buffer) {
+        std::lock_guard<std::mutex> lock(csTraceBuffers);
+        if (!vTraceBuffersFree.empty()) {
+            threadSlot.buffer = vTraceBuffersFree.back();
+            vTraceBuffersFree.pop_back();
+        } else {
+            threadSlot.buffer = std::make_shared<TraceBuffer>(vTraceBuffers.size() + 1, std::max(1u, nTraceBufferSize));
+            vTraceBuffers.push_back(threadSlot.buffer);
+        }
+        // Threads are named before they start working, so this is their final name
+        threadSlot.buffer->strThreadName = GetThreadName();
+    }
+    return threadSlot.buffer.get();
+}
+
+void WriteJSONString(std::ostream& os, const char* str, size_t nMaxLen = std::string::npos)
+{
+    os << '"';
+    for (const char* p = str; *p && (size_t)(p - str) < nMaxLen; p++) {
+        if (*p == '"' || *p == '\\')
+            os << '\\' << *p;
+        else if ((unsigned char)*p < 0x20)
+            os << ' ';
+        else
+            os << *p;
+    }
+    os << '"';
+}
+
+} // namespace
+
+void TraceInit(bool fEnable, unsigned int nEventsPerThread)
+{
+    {
+        std::lock_guard<std::mutex> lock(csTraceBuffers);
+        nTraceBufferSize = nEventsPerThread;
+    }
+    TraceSetEnabled(fEnable);
+}
+
+void TraceSetEnabled(bool fEnable)
+{
+    // Start the clock before the first scope reads it
+    TraceNow();
+    fTraceEnabled.store(fEnable, std::memory_order_relaxed);
+}
+
+void TraceRecord(const char* category, const char* name, const char* arg, int64_t nStart, int64_t nEnd)
+{
+    TraceBuffer* buffer = GetThreadBuffer();
+    const uint64_t nIndex = buffer->nWritten.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->vEvents[nIndex % buffer->vEvents.size()];
+    event.category = category;
+    event.name = name;
+    memcpy(event.arg, arg, TRACE_ARG_SIZE);
+    event.nStart = nStart;
+    event.nDuration = nEnd - nStart;
+    buffer->nWritten.store(nIndex + 1, std::memory_order_release);
+}
+
+int64_t TraceWriteChromeJSON(const std::string& path, std::string& strError)
+{
+    std::vector<std::shared_ptr<TraceBuffer> > vBuffers;
+    std::vector<std::string> vThreadNames;
+    {
+        std::lock_guard<std::mutex> lock(csTraceBuffers);
+        vBuffers = vTraceBuffers;
+        for (const auto& buffer : vBuffers)
+            vThreadNames.push_back(buffer->strThreadName);
+    }
+
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        strError = strprintf("Unable to open %s for writing", path);
+        return -1;
+    }
+
+    int64_t nEvents = 0;
+    bool fFirst = true;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t n = 0; n < vBuffers.size(); n++) {
+        const std::shared_ptr<TraceBuffer>& buffer = vBuffers[n];
+        const uint64_t nSize = buffer->vEvents.size();
+        const uint64_t nEnd = buffer->nWritten.load(std::memory_order_acquire);
+        const uint64_t nBegin = nEnd > nSize ? nEnd - nSize : 0;
+        std::vector<TraceEvent> vCopy;
+        vCopy.reserve(nEnd - nBegin);
+        for (uint64_t i = nBegin; i < nEnd; i++)
+            vCopy.push_back(buffer->vEvents[i % nSize]);
+        // Slots below this index may have been rewritten during the copy,
+        // including the one the writer is filling right now
+        const uint64_t nNow = buffer->nWritten.load(std::memory_order_acquire) + 1;
+        const uint64_t nValid = nNow > nSize ? nNow - nSize : 0;
+
+        file << (fFirst ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->nThread << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        WriteJSONString(file, vThreadNames[n].c_str());
+        file << "}}";
+        fFirst = false;
+
+        for (uint64_t i = std::max(nBegin, nValid); i < nEnd; i++) {
+            const TraceEvent& event = vCopy[i - nBegin];
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->nThread << ",\"ts\":" << event.nStart << ",\"dur\":" << event.nDuration << ",\"cat\":";
+            WriteJSONString(file, event.category);
+            file << ",\"name\":";
+            WriteJSONString(file, event.name);
+            if (event.arg[0]) {
+                file << ",\"args\":{\"detail\":";
+                WriteJSONString(file, event.arg, TRACE_ARG_SIZE - 1);
+                file << "}";
+            }
+            file << "}";
+            nEvents++;
+        }
+    }
+    file << "\n]}\n";
+    file.close();
+    if (file.fail()) {
+        strError = strprintf("Unable to write %s", path);
+        return -1;
+    }
+    return nEvents;
+}
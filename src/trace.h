@@ -0,0 +1,94 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CASH_TRACE_H
+#define CASH_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+/** Default for -trace */
+static const bool DEFAULT_TRACE = false;
+/** Default for -tracebuffer, events kept per thread */
+static const unsigned int DEFAULT_TRACE_BUFFER = 65536;
+/** Bytes of the optional scope detail (e.g. a message command) kept per event */
+static const size_t TRACE_ARG_SIZE = 16;
+
+/**
+ * Scoped wall-clock tracing of hot paths.
+ *
+ * TRACE_SCOPE("category", "name") times the enclosing scope. Each thread
+ * appends to its own fixed-size ring buffer without taking a lock, so
+ * tracing can stay enabled under load; the oldest events are overwritten.
+ * When tracing is off a scope costs one relaxed atomic load. Category and
+ * name must be string literals, the detail string is copied.
+ */
+extern std::atomic<bool> fTraceEnabled;
+
+/** Sets the per-thread buffer size (applies to threads tracing for the first time) and enables tracing */
+void TraceInit(bool fEnable, unsigned int nEventsPerThread);
+void TraceSetEnabled(bool fEnable);
+
+/** Microseconds since tracing was first used, the clock of all events */
+inline int64_t TraceNow()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/** Appends a completed scope to the calling thread's buffer */
+void TraceRecord(const char* category, const char* name, const char* arg, int64_t nStart, int64_t nEnd);
+
+/**
+ * Writes all buffered events as a Chrome trace (chrome://tracing, Perfetto)
+ * JSON file. Returns the number of events written, or -1 and strError.
+ */
+int64_t TraceWriteChromeJSON(const std::string& path, std::string& strError);
+
+class CTraceScope
+{
+public:
+    CTraceScope(const char* categoryIn, const char* nameIn) : category(categoryIn), name(nameIn), fActive(fTraceEnabled.load(std::memory_order_relaxed)), nStart(0)
+    {
+        if (fActive) {
+            arg[0] = '\0';
+            nStart = TraceNow();
+        }
+    }
+
+    CTraceScope(const char* categoryIn, const char* nameIn, const std::string& strArg) : category(categoryIn), name(nameIn), fActive(fTraceEnabled.load(std::memory_order_relaxed)), nStart(0)
+    {
+        if (fActive) {
+            size_t nLen = strArg.copy(arg, TRACE_ARG_SIZE - 1);
+            arg[nLen] = '\0';
+            nStart = TraceNow();
+        }
+    }
+
+    ~CTraceScope()
+    {
+        if (fActive)
+            TraceRecord(category, name, arg, nStart, TraceNow());
+    }
+
+    CTraceScope(const CTraceScope&) = delete;
+    CTraceScope& operator=(const CTraceScope&) = delete;
+
+private:
+    const char* category;
+    const char* name;
+    const bool fActive;
+    char arg[TRACE_ARG_SIZE];
+    int64_t nStart;
+};
+
+#define TRACE_PASTE(x, y) x ## y
+#define TRACE_PASTE2(x, y) TRACE_PASTE(x, y)
+
+#define TRACE_SCOPE(category, name) CTraceScope TRACE_PASTE2(tracescope, __COUNTER__)(category, name)
+#define TRACE_SCOPE_ARG(category, name, arg) CTraceScope TRACE_PASTE2(tracescope, __COUNTER__)(category, name, arg)
+
+#endif // CASH_TRACE_H
@@ -13,8 +13,10 @@
 #include "pow.h"
 #include "ui_interface.h"
 #include "uint256.h"
+#include "util.h"
 
 #include <stdint.h>
+#include <thread>
 
 #include <boost/thread.hpp>
 
@@ -365,44 +367,92 @@ bool CBlockTreeDB::ReadFlag(const std::string& name, bool& fValue)
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+namespace
 {
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+/** One key range shard of DB_BLOCK_INDEX, deserialized on its own thread */
+struct CBlockIndexShard {
+    unsigned char nBegin;
+    unsigned int nEnd;
+    std::vector<CDiskBlockIndex> vEntries;
+    std::string strError;
+};
 
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+void LoadBlockIndexShard(CDBWrapper& db, CBlockIndexShard& shard)
+{
+    uint256 hashBegin;
+    *hashBegin.begin() = shard.nBegin;
+
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, hashBegin));
 
-    // Load mapBlockIndex
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
         std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight = diskindex.nHeight;
-                pindexNew->nFile = diskindex.nFile;
-                pindexNew->nDataPos = diskindex.nDataPos;
-                pindexNew->nUndoPos = diskindex.nUndoPos;
-                pindexNew->nVersion = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime = diskindex.nTime;
-                pindexNew->nBits = diskindex.nBits;
-                pindexNew->nNonce = diskindex.nNonce;
-                pindexNew->nStatus = diskindex.nStatus;
-                pindexNew->nTx = diskindex.nTx;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, Params().GetConsensus()))
-                    return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
-
-                pcursor->Next();
-            } else {
-                return error("LoadBlockIndex() : failed to read value");
-            }
-        } else {
+        // Keys are ordered by the serialized hash, so the shard ends at its first byte
+        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX || *key.second.begin() >= shard.nEnd)
             break;
+        CDiskBlockIndex diskindex;
+        if (!pcursor->GetValue(diskindex)) {
+            shard.strError = "failed to read value";
+            return;
+        }
+        // The stored hash is the one the index was written under; checking it
+        // against the header again would cost an Argon2d hash per entry.
+        diskindex.hash = key.second;
+        if (!CheckProofOfWork(diskindex.hash, diskindex.nBits, Params().GetConsensus())) {
+            shard.strError = strprintf("CheckProofOfWork failed: %s", diskindex.ToString());
+            return;
+        }
+        shard.vEntries.push_back(diskindex);
+        pcursor->Next();
+    }
+}
+} // namespace
+
+bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, boost::function<void(size_t)> reserveBlockIndex)
+{
+    // Deserialize the index over key range shards in parallel
+    const int nShards = std::max(1, std::min(GetNumCores(), MAX_BLOCK_INDEX_LOAD_THREADS));
+    std::vector<CBlockIndexShard> vShards(nShards);
+    for (int i = 0; i < nShards; i++) {
+        vShards[i].nBegin = i * 256 / nShards;
+        vShards[i].nEnd = (i + 1) * 256 / nShards;
+    }
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nShards; i++)
+        vThreads.emplace_back(LoadBlockIndexShard, std::ref(*this), std::ref(vShards[i]));
+    LoadBlockIndexShard(*this, vShards[0]);
+    for (std::thread& thread : vThreads)
+        thread.join();
+
+    size_t nEntries = 0;
+    for (const CBlockIndexShard& shard : vShards) {
+        if (!shard.strError.empty())
+            return error("LoadBlockIndex() : %s", shard.strError);
+        nEntries += shard.vEntries.size();
+    }
+    if (reserveBlockIndex)
+        reserveBlockIndex(nEntries);
+
+    // Load mapBlockIndex
+    for (CBlockIndexShard& shard : vShards) {
+        boost::this_thread::interruption_point();
+        for (const CDiskBlockIndex& diskindex : shard.vEntries) {
+            // Construct block index object
+            CBlockIndex* pindexNew = insertBlockIndex(diskindex.hash);
+            pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nTx = diskindex.nTx;
         }
+        std::vector<CDiskBlockIndex>().swap(shard.vEntries);
     }
 
     return true;
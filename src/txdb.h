@@ -44,6 +44,10 @@ static const int64_t nMaxBlockDBCache = 18;
 static const int64_t nMaxBlockDBAndTxIndexCache = 3072;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 54;
+//! Memory for the write buffers of each BDAP, fluid and DHT database (MiB)
+static const int64_t nAuxDBCache = 4;
+//! Max threads reading key range shards of the block index at startup
+static const int MAX_BLOCK_INDEX_LOAD_THREADS = 8;
 
 struct CDiskTxPos : public CDiskBlockPos {
     unsigned int nTxOffset; // after header
@@ -143,7 +147,7 @@ public:
     bool ReadTimestampIndex(const unsigned int& high, const unsigned int& low, std::vector<uint256>& vect);
     bool WriteFlag(const std::string& name, bool fValue);
     bool ReadFlag(const std::string& name, bool& fValue);
-    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, boost::function<void(size_t)> reserveBlockIndex = NULL);
 };
 
 #endif // CASH_TXDB_H
@@ -92,6 +92,15 @@
 #include <openssl/crypto.h>
 #include <openssl/rand.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
 // Work around clang compilation problem in Boost 1.46:
 // /usr/include/boost/program_options/detail/config_file.hpp:163:17: error: call to function 'to_internal' that is neither visible in the template definition nor found by argument-dependent lookup
 // See also: http://stackoverflow.com/questions/10020179/compilation-fail-in-boost-librairies-program-options
@@ -245,62 +254,56 @@ void OpenDebugLog()
     vMsgsBeforeOpenLog = NULL;
 }
 
-bool LogAcceptCategory(const char* category)
-{
-    if (category != NULL) {
-        // Give each thread quick access to -debug settings.
-        // This helps prevent issues debugging global destructors,
-        // where mapMultiArgs might be deleted before another
-        // global destructor calls LogPrint()
-        static boost::thread_specific_ptr<std::set<std::string> > ptrCategory;
-
-        if (!fDebug) {
-            if (ptrCategory.get() != NULL) {
-                LogPrintf("debug turned off: thread %s\n", GetThreadName());
-                ptrCategory.release();
-            }
-            return false;
-        }
+std::atomic<uint64_t> nLogCategoriesEnabled(0);
+/** -debug values that are not in LOG_CATEGORY_NAMES */
+static CCriticalSection cs_logCategories;
+static std::set<std::string> setLogCategoriesUnknown;
+static bool fLogCategoriesAll = false;
 
-        if (ptrCategory.get() == NULL) {
-            if (mapMultiArgs.count("-debug")) {
-                std::string strThreadName = GetThreadName();
-                LogPrintf("debug turned on:\n");
-                for (int i = 0; i < (int)mapMultiArgs.at("-debug").size(); ++i)
-                    LogPrintf("  thread %s category %s\n", strThreadName, mapMultiArgs.at("-debug")[i]);
-                const std::vector<std::string>& categories = mapMultiArgs.at("-debug");
-                ptrCategory.reset(new std::set<std::string>(categories.begin(), categories.end()));
-                // thread_specific_ptr automatically deletes the set when the thread ends.
-                // "cash" is a composite category enabling all Cash-related debug output
-                //addrman|alert|bench|coindb|db|lock|rand|rpc|selectcoins|mempool"
-                //"|mempoolrej|net|proxy|prune|http|libevent|tor|zmq|"
-                //"cash|privatesend|instantsend|masternode|spork|keepass|mnpayments|gobject|dht|bdap|validation|stealth|
-                if (ptrCategory->count(std::string("cash"))) {
-                    ptrCategory->insert(std::string("privatesend"));
-                    ptrCategory->insert(std::string("instantsend"));
-                    ptrCategory->insert(std::string("masternode"));
-                    ptrCategory->insert(std::string("spork"));
-                    ptrCategory->insert(std::string("keepass"));
-                    ptrCategory->insert(std::string("mnpayments"));
-                    ptrCategory->insert(std::string("gobject"));
-                    ptrCategory->insert(std::string("dht"));
-                    ptrCategory->insert(std::string("bdap"));
-                    ptrCategory->insert(std::string("validation"));
-                    ptrCategory->insert(std::string("stealth"));
-                }
-            } else {
-                ptrCategory.reset(new std::set<std::string>());
-            }
+void UpdateLogCategories()
+{
+    std::set<std::string> setCategories;
+    if (fDebug && mapMultiArgs.count("-debug")) {
+        const std::vector<std::string>& categories = mapMultiArgs.at("-debug");
+        setCategories.insert(categories.begin(), categories.end());
+        // "cash" is a composite category enabling all Cash-related debug output
+        if (setCategories.count(std::string("cash"))) {
+            setCategories.insert(std::string("privatesend"));
+            setCategories.insert(std::string("instantsend"));
+            setCategories.insert(std::string("masternode"));
+            setCategories.insert(std::string("spork"));
+            setCategories.insert(std::string("keepass"));
+            setCategories.insert(std::string("mnpayments"));
+            setCategories.insert(std::string("gobject"));
+            setCategories.insert(std::string("dht"));
+            setCategories.insert(std::string("bdap"));
+            setCategories.insert(std::string("validation"));
+            setCategories.insert(std::string("stealth"));
         }
-        const std::set<std::string>& setCategories = *ptrCategory.get();
+    }
 
-        // if not debugging everything and not debugging specific category, LogPrint does nothing.
-        if (setCategories.count(std::string("")) == 0 &&
-            setCategories.count(std::string("1")) == 0 &&
-            setCategories.count(std::string(category)) == 0)
-            return false;
+    // if not debugging everything and not debugging specific category, LogPrint does nothing.
+    bool fAll = setCategories.count(std::string("")) || setCategories.count(std::string("1"));
+    uint64_t nMask = 0;
+    for (int i = 0; i < LOG_CATEGORY_COUNT; i++) {
+        if (fAll || setCategories.erase(std::string(LOG_CATEGORY_NAMES[i])))
+            nMask |= (uint64_t)1 << i;
     }
-    return true;
+
+    LOCK(cs_logCategories);
+    fLogCategoriesAll = fAll;
+    setLogCategoriesUnknown.swap(setCategories);
+    nLogCategoriesEnabled = nMask;
+}
+
+bool LogAcceptCategory(const char* category)
+{
+    int nCategory = LogCategoryIndex(category);
+    if (nCategory != LOG_CATEGORY_UNKNOWN)
+        return LogAcceptCategoryIndex(nCategory, category);
+
+    LOCK(cs_logCategories);
+    return fLogCategoriesAll || setLogCategoriesUnknown.count(std::string(category));
 }
 
 /**
@@ -349,6 +352,244 @@ static std::string LogThreadNameStr(const std::string& str, std::atomic_bool* fS
     return strThreadLogged;
 }
 
+/**
+ * Asynchronous debug.log writer.
+ *
+ * Every logging thread owns a single-producer ring of lines that only it
+ * appends to and only the writer thread consumes, so producers never take a
+ * lock on the hot path. The writer wakes up every LOG_WRITER_INTERVAL_MS, or
+ * earlier when a ring is half full, merges the drained lines back into
+ * global order and writes them with a single fwrite. A line gets its
+ * sequence number before it is published, so the writer holds back every
+ * line numbered at or after the oldest one still being appended until a
+ * later pass; the file is in global order across batches. A producer finding
+ * its ring full waits up to LOG_BACKPRESSURE_MS for the writer, then drops
+ * the line; drops are counted and reported in the log itself.
+ *
+ * Like the rest of the debug.log state, the writer state is leaked on exit.
+ */
+static const int64_t LOG_WRITER_INTERVAL_MS = 100;
+static const int64_t LOG_BACKPRESSURE_MS = 10;
+
+namespace {
+const uint64_t NO_PENDING_LINE = std::numeric_limits<uint64_t>::max();
+
+struct CLogRing {
+    std::vector<std::pair<uint64_t, std::string> > vSlots; // sequence, line
+    std::atomic<uint64_t> nHead;
+    std::atomic<uint64_t> nTail;
+    std::atomic<bool> fOrphaned;
+    //! lower bound of the sequence number of the line being appended, NO_PENDING_LINE if none
+    std::atomic<uint64_t> nPending;
+
+    explicit CLogRing(size_t nSize) : vSlots(nSize), nHead(0), nTail(0), fOrphaned(false), nPending(NO_PENDING_LINE) {}
+};
+
+/** Marks the ring of an exiting thread for removal once the writer drained it */
+struct CLogRingHolder {
+    std::shared_ptr<CLogRing> ring;
+    ~CLogRingHolder()
+    {
+        if (ring)
+            ring->fOrphaned = true;
+    }
+};
+
+struct CLogWriter {
+    std::mutex mutexRings;
+    std::vector<std::shared_ptr<CLogRing> > vRings;
+    size_t nRingSize;
+
+    std::mutex mutexWake;
+    std::condition_variable condWake;
+    bool fWake;
+    bool fStop;
+    std::thread thread;
+
+    std::atomic<uint64_t> nSequence;
+    std::atomic<uint64_t> nDropped;
+    uint64_t nDroppedReported;
+    //! drained lines that must wait for an older line still being appended
+    std::vector<std::pair<uint64_t, std::string> > vHeld;
+
+    CLogWriter() : nRingSize(DEFAULT_LOGBUFFER), fWake(false), fStop(false), nSequence(0), nDropped(0), nDroppedReported(0) {}
+};
+} // namespace
+
+static CLogWriter* logWriter = NULL;
+static std::atomic<bool> fLogWriterRunning(false);
+static std::atomic<int> nLogProducers(0);
+static thread_local CLogRingHolder logRingHolder;
+
+static void WakeLogWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(logWriter->mutexWake);
+        logWriter->fWake = true;
+    }
+    logWriter->condWake.notify_one();
+}
+
+/** Queue a line for the writer thread. Returns false if the writer is not running. */
+static bool LogEnqueue(std::string& str)
+{
+    nLogProducers++;
+    if (!fLogWriterRunning) {
+        nLogProducers--;
+        return false;
+    }
+
+    if (!logRingHolder.ring) {
+        logRingHolder.ring = std::make_shared<CLogRing>(logWriter->nRingSize);
+        std::lock_guard<std::mutex> lock(logWriter->mutexRings);
+        logWriter->vRings.push_back(logRingHolder.ring);
+    }
+    CLogRing& ring = *logRingHolder.ring;
+    const uint64_t nSize = ring.vSlots.size();
+    const uint64_t nHead = ring.nHead.load(std::memory_order_relaxed);
+
+    if (nHead - ring.nTail.load(std::memory_order_acquire) >= nSize) {
+        WakeLogWriter();
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(LOG_BACKPRESSURE_MS);
+        while (nHead - ring.nTail.load(std::memory_order_acquire) >= nSize) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                logWriter->nDropped++;
+                nLogProducers--;
+                return true;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Announced before the number is taken, so the writer holds back newer lines until this one is published
+    ring.nPending.store(logWriter->nSequence.load());
+    std::pair<uint64_t, std::string>& slot = ring.vSlots[nHead % nSize];
+    slot.first = logWriter->nSequence++;
+    slot.second.swap(str);
+    ring.nHead.store(nHead + 1, std::memory_order_release);
+    ring.nPending.store(NO_PENDING_LINE);
+    nLogProducers--;
+
+    if (nHead + 1 - ring.nTail.load(std::memory_order_relaxed) == nSize / 2)
+        WakeLogWriter();
+    return true;
+}
+
+/**
+ * Move the lines queued so far to debug.log, except those that have to wait
+ * for an older line still being appended. fFinal writes everything, once no
+ * producer is left.
+ */
+static void LogWriterFlush(bool fFinal = false)
+{
+    std::vector<std::pair<uint64_t, std::string> > vBatch;
+    vBatch.swap(logWriter->vHeld);
+    uint64_t nLimit = logWriter->nSequence.load();
+    {
+        std::lock_guard<std::mutex> lock(logWriter->mutexRings);
+        // Every line numbered below nLimit is published before the rings are drained
+        for (const std::shared_ptr<CLogRing>& ring : logWriter->vRings)
+            nLimit = std::min(nLimit, ring->nPending.load());
+        for (size_t i = 0; i < logWriter->vRings.size();) {
+            CLogRing& ring = *logWriter->vRings[i];
+            // Read before nHead: once set, the owning thread will not push again
+            bool fOrphaned = ring.fOrphaned.load(std::memory_order_acquire);
+            uint64_t nHead = ring.nHead.load(std::memory_order_acquire);
+            uint64_t nTail = ring.nTail.load(std::memory_order_relaxed);
+            for (; nTail != nHead; nTail++) {
+                std::pair<uint64_t, std::string>& slot = ring.vSlots[nTail % ring.vSlots.size()];
+                vBatch.push_back(std::make_pair(slot.first, std::string()));
+                vBatch.back().second.swap(slot.second);
+            }
+            ring.nTail.store(nTail, std::memory_order_release);
+            if (fOrphaned) {
+                logWriter->vRings[i] = logWriter->vRings.back();
+                logWriter->vRings.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    std::sort(vBatch.begin(), vBatch.end(), [](const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b) {
+        return a.first < b.first;
+    });
+    size_t nWrite = vBatch.size();
+    if (!fFinal) {
+        while (nWrite > 0 && vBatch[nWrite - 1].first >= nLimit)
+            nWrite--;
+        logWriter->vHeld.assign(std::make_move_iterator(vBatch.begin() + nWrite), std::make_move_iterator(vBatch.end()));
+    }
+
+    uint64_t nDropped = logWriter->nDropped.load();
+    if (nWrite == 0 && nDropped == logWriter->nDroppedReported)
+        return;
+
+    std::string strBatch;
+    for (size_t i = 0; i < nWrite; i++)
+        strBatch += vBatch[i].second;
+    if (nDropped != logWriter->nDroppedReported) {
+        strBatch += strprintf("%s: %u lines dropped, log buffer full (total %u)\n", __func__, nDropped - logWriter->nDroppedReported, nDropped);
+        logWriter->nDroppedReported = nDropped;
+    }
+
+    boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+        if (freopen(pathDebug.string().c_str(), "a", fileout) != NULL)
+            setbuf(fileout, NULL); // unbuffered
+    }
+    FileWriteStr(strBatch, fileout);
+}
+
+static void LogWriterThread()
+{
+    RenameThread("cash-logwriter");
+    while (true) {
+        bool fStop;
+        {
+            std::unique_lock<std::mutex> lock(logWriter->mutexWake);
+            logWriter->condWake.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_INTERVAL_MS), [] { return logWriter->fWake || logWriter->fStop; });
+            logWriter->fWake = false;
+            fStop = logWriter->fStop;
+        }
+        if (fStop)
+            break;
+        LogWriterFlush();
+    }
+}
+
+void StartDebugLogWriter(size_t nBufferLines)
+{
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    if (fileout == NULL || fLogWriterRunning)
+        return;
+    if (logWriter == NULL)
+        logWriter = new CLogWriter();
+    logWriter->nRingSize = std::max<size_t>(2, nBufferLines);
+    logWriter->fStop = false;
+    logWriter->thread = std::thread(&LogWriterThread);
+    fLogWriterRunning = true;
+}
+
+void StopDebugLogWriter()
+{
+    if (!fLogWriterRunning)
+        return;
+    fLogWriterRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(logWriter->mutexWake);
+        logWriter->fStop = true;
+    }
+    logWriter->condWake.notify_one();
+    logWriter->thread.join();
+    // Producers that saw the writer running may still be appending
+    while (nLogProducers > 0)
+        std::this_thread::yield();
+    LogWriterFlush(true);
+}
+
 int LogPrintStr(const std::string& str)
 {
     int ret = 0; // Returns total number of characters written
@@ -367,6 +608,10 @@ int LogPrintStr(const std::string& str)
         ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
         fflush(stdout);
     } else if (fPrintToDebugLog) {
+        ret = strTimestamped.length();
+        if (LogEnqueue(strTimestamped))
+            return ret;
+
         boost::call_once(&DebugPrintInit, debugPrintInitFlag);
         boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
 
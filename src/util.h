@@ -57,6 +57,9 @@ static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+static const bool DEFAULT_LOGASYNC = false;
+/** Default for -logbuffer, lines queued per logging thread for the debug.log writer */
+static const unsigned int DEFAULT_LOGBUFFER = 4096;
 
 /** Signals for translation. */
 class CTranslationInterface
@@ -93,21 +96,82 @@ inline std::string _(const char* psz)
 void SetupEnvironment();
 bool SetupNetworking();
 
+/**
+ * Debug log categories. LogPrint resolves its category to an index in this
+ * table at compile time and checks it against a bitmask before any of its
+ * arguments are evaluated. Keep sorted; at most 64 entries.
+ */
+static constexpr const char* const LOG_CATEGORY_NAMES[] = {
+    "addrman", "alert", "bdap", "bench", "cmpctblock", "coindb", "creation", "db", "dht", "estimatefee",
+    "fluid", "gobject", "http", "instantsend", "keepass", "leveldb", "libevent", "lock", "masternode", "mempool",
+    "mempoolrej", "mnpayments", "mnsync", "net", "privatesend", "proxy", "prune", "qt", "rand", "reindex",
+    "rpc", "selectcoins", "spork", "stealth", "stratum", "tor", "validation", "wallet", "zmq"};
+static constexpr int LOG_CATEGORY_COUNT = sizeof(LOG_CATEGORY_NAMES) / sizeof(LOG_CATEGORY_NAMES[0]);
+static_assert(LOG_CATEGORY_COUNT <= 64, "log category mask is 64 bits");
+/** LogPrintf, always logged */
+static constexpr int LOG_CATEGORY_ALWAYS = -1;
+/** Category not in LOG_CATEGORY_NAMES, matched by name at runtime */
+static constexpr int LOG_CATEGORY_UNKNOWN = -2;
+
+/**
+ * Categories compiled into the binary, as a mask of LOG_CATEGORY_NAMES
+ * indexes. Release builds can define it (0 with --disable-debug-log) to
+ * drop LogPrint calls of the other categories altogether.
+ */
+#ifndef LOG_CATEGORIES_COMPILED
+#define LOG_CATEGORIES_COMPILED (~(uint64_t)0)
+#endif
+
+constexpr bool LogCategoryEqual(const char* a, const char* b)
+{
+    return *a == *b && (*a == '\0' || LogCategoryEqual(a + 1, b + 1));
+}
+
+constexpr int LogCategoryIndex(const char* category, int i = 0)
+{
+    return category == nullptr ? LOG_CATEGORY_ALWAYS :
+           i == LOG_CATEGORY_COUNT ? LOG_CATEGORY_UNKNOWN :
+           LogCategoryEqual(category, LOG_CATEGORY_NAMES[i]) ? i : LogCategoryIndex(category, i + 1);
+}
+
+constexpr bool LogCategoryCompiled(int nCategory)
+{
+    return nCategory < 0 || ((LOG_CATEGORIES_COMPILED >> nCategory) & 1);
+}
+
+/** Enabled categories, bit i for LOG_CATEGORY_NAMES[i]; 0 unless fDebug */
+extern std::atomic<uint64_t> nLogCategoriesEnabled;
+
+/** Recompute the enabled categories from fDebug and -debug, call after changing either */
+void UpdateLogCategories();
 /** Return true if log accepts specified category */
 bool LogAcceptCategory(const char* category);
 /** Send a string to the log output */
 int LogPrintStr(const std::string& str);
 
-#define LogPrintf(...) LogPrint(NULL, __VA_ARGS__)
-
-template <typename... Args>
-static inline int LogPrint(const char* category, const char* fmt, const Args&... args)
+static inline bool LogAcceptCategoryIndex(int nCategory, const char* category)
 {
-    if (!LogAcceptCategory(category))
-        return 0;
-    return LogPrintStr(tfm::format(fmt, args...));
+    if (nCategory == LOG_CATEGORY_ALWAYS)
+        return true;
+    if (nCategory == LOG_CATEGORY_UNKNOWN)
+        return LogAcceptCategory(category);
+    return (nLogCategoriesEnabled.load(std::memory_order_relaxed) >> nCategory) & 1;
 }
 
+/**
+ * The category must be a string literal (or NULL). The format arguments are
+ * only evaluated if the category is enabled, so LogPrint can be used with
+ * expensive arguments on hot paths.
+ */
+#define LogPrint(category, ...)                                                         \
+    do {                                                                                \
+        constexpr int nLogCategory = LogCategoryIndex(category);                        \
+        if (LogCategoryCompiled(nLogCategory) && LogAcceptCategoryIndex(nLogCategory, category)) \
+            LogPrintStr(tfm::format(__VA_ARGS__));                                      \
+    } while (0)
+
+#define LogPrintf(...) LogPrint(NULL, __VA_ARGS__)
+
 template <typename... Args>
 bool error(const char* fmt, const Args&... args)
 {
@@ -155,6 +219,10 @@ void ReadConfigFile(const std::string& confPath);
 boost::filesystem::path GetSpecialFolderPath(int nFolder, bool fCreate = true);
 #endif
 void OpenDebugLog();
+/** Hand debug.log writes to a background thread, see -logasync. Needs OpenDebugLog() first. */
+void StartDebugLogWriter(size_t nBufferLines);
+/** Write out everything queued and go back to writing synchronously */
+void StopDebugLogWriter();
 void ShrinkDebugFile();
 void runCommand(const std::string& strCommand);
 
@@ -51,6 +51,7 @@
 #include "spork.h"
 #include "timedata.h"
 #include "tinyformat.h"
+#include "trace.h"
 #include "txdb.h"
 #include "txmempool.h"
 #include "ui_interface.h"
@@ -64,7 +65,9 @@
 #include "warnings.h"
 
 #include <atomic>
+#include <future>
 #include <sstream>
+#include <thread>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
@@ -95,6 +98,7 @@ std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 std::map<unsigned int, unsigned int> mapHashedBlocks;
 int nScriptCheckThreads = 0;
+int nScriptCheckDepth = DEFAULT_SCRIPT_CHECK_DEPTH;
 std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = true;
@@ -108,6 +112,7 @@ bool fRequireStandard = true;
 unsigned int nBytesPerSigOp = DEFAULT_BYTES_PER_SIGOP;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
+bool fIncrementalFlush = DEFAULT_INCREMENTAL_FLUSH;
 size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
 bool fAlerts = DEFAULT_ALERTS;
@@ -1908,7 +1913,7 @@ bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHea
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+static bool ReadBlockFromDiskUnchecked(CBlock& block, const CDiskBlockPos& pos)
 {
     block.SetNull();
 
@@ -1924,6 +1929,14 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+{
+    if (!ReadBlockFromDiskUnchecked(block, pos))
+        return false;
+
     // Check the header
     if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
@@ -1933,11 +1946,21 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
 
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    if (!ReadBlockFromDisk(block, pindex->GetBlockPos(), consensusParams))
+    if (!ReadBlockFromDiskUnchecked(block, pindex->GetBlockPos()))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
-        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
+
+    // The index entry's hash already passed proof-of-work when it was accepted,
+    // so a header identical to the indexed one needs no Argon2d re-verification.
+    const CBlockHeader indexHeader = pindex->GetBlockHeader();
+    if (block.nVersion != indexHeader.nVersion ||
+        block.hashPrevBlock != indexHeader.hashPrevBlock ||
+        block.hashMerkleRoot != indexHeader.hashMerkleRoot ||
+        block.nTime != indexHeader.nTime ||
+        block.nBits != indexHeader.nBits ||
+        block.nNonce != indexHeader.nNonce)
+        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): header doesn't match index for %s at %s",
             pindex->ToString(), pindex->GetBlockPos().ToString());
+    block.SetCachedHash(pindex->GetBlockHash());
     return true;
 }
 
@@ -2585,12 +2608,127 @@ bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigne
 
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
+/**
+ * Script checks of several consecutive blocks that share one check queue
+ * session during initial block download. The blocks are connected to the
+ * chain state as soon as their UTXO changes are applied; their scripts are
+ * verified by the queue workers in the background and the blocks are only
+ * marked BLOCK_VALID_SCRIPTS once the whole window has been waited for.
+ */
+struct CDeferredScriptChecks {
+    std::unique_ptr<CCheckQueueControl<CScriptCheck> > control;
+    //! Blocks connected in this window, in connection order
+    std::vector<std::pair<CBlockIndex*, std::shared_ptr<const CBlock> > > vBlocks;
+    //! Size of the ConnectTrace when the window was opened
+    size_t nTraceStart;
+
+    CDeferredScriptChecks() : nTraceStart(0) {}
+};
+
+/** Blocks on chainActive whose script checks are still outstanding; the chain state is not flushed while non-zero. */
+static unsigned int nDeferredScriptBlocks = 0;
+
+/** Height of the last block of the most recent window whose scripts failed; scripts are verified per block until the tip reaches it. */
+static int nDeferredScriptsFailedHeight = -1;
+
 void ThreadScriptCheck()
 {
     RenameThread("cash-scriptch");
     scriptcheckqueue.Thread();
 }
 
+/** Closure representing one header's proof-of-work check */
+class CHeaderCheck
+{
+private:
+    const CBlockHeader* pheader;
+    const Consensus::Params* pconsensusParams;
+
+public:
+    CHeaderCheck() : pheader(NULL), pconsensusParams(NULL) {}
+    CHeaderCheck(const CBlockHeader& header, const Consensus::Params& consensusParams) : pheader(&header), pconsensusParams(&consensusParams) {}
+
+    bool operator()()
+    {
+        return CheckProofOfWork(pheader->GetHash(), pheader->nBits, *pconsensusParams);
+    }
+
+    void swap(CHeaderCheck& check)
+    {
+        std::swap(pheader, check.pheader);
+        std::swap(pconsensusParams, check.pconsensusParams);
+    }
+};
+
+static CCheckQueue<CHeaderCheck> headercheckqueue(8);
+
+void ThreadHeaderCheck()
+{
+    RenameThread("cash-headerch");
+    // Each thread hashes headers of its own, keep off the Argon2d lane workers
+    Argon2dSetThreadParallel(false);
+    headercheckqueue.Thread();
+}
+
+/** Closure representing one database read of a coin spent by a block being connected */
+class CCoinPrefetch
+{
+private:
+    const COutPoint* poutpoint;
+    Coin* pcoin;
+    char* pfFound;
+
+public:
+    CCoinPrefetch() : poutpoint(NULL), pcoin(NULL), pfFound(NULL) {}
+    CCoinPrefetch(const COutPoint& outpoint, Coin& coin, char& fFound) : poutpoint(&outpoint), pcoin(&coin), pfFound(&fFound) {}
+
+    bool operator()()
+    {
+        try {
+            *pfFound = pcoinsdbview->GetCoin(*poutpoint, *pcoin);
+        } catch (const std::runtime_error&) {
+            // Leave it to the regular lookup, which handles database errors.
+        }
+        return true;
+    }
+
+    void swap(CCoinPrefetch& check)
+    {
+        std::swap(poutpoint, check.poutpoint);
+        std::swap(pcoin, check.pcoin);
+        std::swap(pfFound, check.pfFound);
+    }
+};
+
+static CCheckQueue<CCoinPrefetch> prefetchqueue(16);
+
+void ThreadCoinPrefetch()
+{
+    RenameThread("cash-prefetch");
+    prefetchqueue.Thread();
+}
+
+bool CheckBlockHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+{
+    TRACE_SCOPE("pow", "CheckBlockHeadersProofOfWork");
+    if (!nScriptCheckThreads || headers.size() < 2) {
+        for (const CBlockHeader& header : headers) {
+            if (!CheckProofOfWork(header.GetHash(), header.nBits, consensusParams))
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<CHeaderCheck> vChecks;
+    vChecks.reserve(headers.size());
+    for (const CBlockHeader& header : headers)
+        vChecks.push_back(CHeaderCheck(header, consensusParams));
+
+    CCheckQueueControl<CHeaderCheck> control(&headercheckqueue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2677,9 +2815,13 @@ static int64_t nTimeTotal = 0;
 
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
- *  can fail if those validity checks fail (among other reasons). */
-static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false)
+ *  can fail if those validity checks fail (among other reasons).
+ *  With pdeferredChecks, script checks are added to that queue session instead
+ *  of being waited for, and the caller marks the block BLOCK_VALID_SCRIPTS once
+ *  they have completed. */
+static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false, CCheckQueueControl<CScriptCheck>* pdeferredChecks = NULL)
 {
+    TRACE_SCOPE("validation", "ConnectBlock");
     AssertLockHeld(cs_main);
 
     int64_t nTimeStart = GetTimeMicros();
@@ -2760,7 +2902,16 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
+    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads && !pdeferredChecks ? &scriptcheckqueue : NULL);
+    CCheckQueueControl<CScriptCheck>& checkControl = pdeferredChecks ? *pdeferredChecks : control;
+
+    // Hand script checks to the queue in batches sized to the block, so workers
+    // start early on large blocks without being woken up for every input.
+    size_t nBlockInputs = 0;
+    for (const auto& tx : block.vtx)
+        nBlockInputs += tx->vin.size();
+    const size_t nCheckBatch = std::max<size_t>(1, std::min<size_t>(128, nBlockInputs / (2 * (nScriptCheckThreads + 1))));
+    std::vector<CScriptCheck> vChecks;
 
     std::vector<uint256> vOrphanErase;
     std::vector<int> prevheights;
@@ -2849,12 +3000,14 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
             nFees += view.GetValueIn(tx) - tx.GetValueOut();
 
-            std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, nScriptCheckThreads ? &vChecks : NULL))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
-            control.Add(vChecks);
+            if (vChecks.size() >= nCheckBatch) {
+                checkControl.Add(vChecks);
+                vChecks.clear();
+            }
         }
 
         if (fAddressIndex) {
@@ -2913,6 +3066,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         vPos.push_back(std::make_pair(tx.GetHash(), pos));
         pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
     }
+    checkControl.Add(vChecks);
     int64_t nTime3 = GetTimeMicros();
     nTimeConnect += nTime3 - nTime2;
     LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs - 1), nTimeConnect * 0.000001);
@@ -3060,8 +3214,10 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             pindex->nStatus |= BLOCK_HAVE_UNDO;
         }
 
-        pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
-        setDirtyBlockIndex.insert(pindex);
+        if (!pdeferredChecks) {
+            pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
+            setDirtyBlockIndex.insert(pindex);
+        }
     }
 
     if (fTxIndex)
@@ -3106,17 +3262,39 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     return true;
 }
 
+/** Chain state write started by an incremental flush, still running in the background. */
+static std::future<bool> futureChainStateWrite;
+
+/** Wait for the background chain state write, if any. Returns false if it failed. */
+static bool WaitForChainStateWrite()
+{
+    if (!futureChainStateWrite.valid())
+        return true;
+    int64_t nStart = GetTimeMicros();
+    bool fOk = futureChainStateWrite.get();
+    LogPrint("bench", "    - Wait for background chainstate write: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
+    return fOk;
+}
+
 /**
  * Update the on-disk chain state.
  * The caches and indexes are flushed depending on the mode we're called with
  * if they're too large, if it's been a while since the last write,
  * or always and in all cases if we're in prune mode and are deleting files.
+ *
+ * With -incrementalflush, flushes other than FLUSH_STATE_ALWAYS and those needed
+ * for pruning hand the modified coins to a background thread once the initial
+ * block download is over, and keep the coins cache warm: only the least
+ * recently used unmodified coins are evicted to make room.
  */
 bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode, int nManualPruneHeight)
 {
     int64_t nMempoolUsage = mempool.DynamicMemoryUsage();
     const CChainParams& chainparams = Params();
     LOCK2(cs_main, cs_LastBlockFile);
+    // Never persist a chain state that includes blocks whose scripts have not been verified yet.
+    if (nDeferredScriptBlocks > 0 && mode != FLUSH_STATE_ALWAYS)
+        return true;
     static int64_t nLastWrite = 0;
     static int64_t nLastFlush = 0;
     static int64_t nLastSetChain = 0;
@@ -3150,8 +3328,16 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode, int n
             nLastSetChain = nNow;
         }
         int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR;
         int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
+        // Once the background write has landed, the coins it took are safe to
+        // evict. Do so now rather than waiting for it at the next full flush.
+        if (futureChainStateWrite.valid() && futureChainStateWrite.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            if (!WaitForChainStateWrite())
+                return AbortNode(state, "Failed to write to coin database");
+            size_t nEvicted = pcoinsTip->EvictClean(nTotalSpace * 3 / 4 / DB_PEAK_USAGE_FACTOR);
+            LogPrint("coindb", "%s: background write done, evicted %u coins\n", __func__, (unsigned int)nEvicted);
+        }
+        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR;
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
         bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize > std::min(std::max(nTotalSpace / 2, nTotalSpace - MIN_BLOCK_COINSDB_USAGE * 1024 * 1024),
                                                                                 std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024));
@@ -3202,9 +3388,27 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode, int n
             // overwrite one. Still, use a conservative safety factor of 2.
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
-            // Flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
+            // The previous background write must be complete before the next one
+            // starts, and before the coins it marked unmodified can be evicted.
+            // It was usually reaped above already, so this rarely blocks.
+            if (!WaitForChainStateWrite())
                 return AbortNode(state, "Failed to write to coin database");
+            if (fIncrementalFlush && mode != FLUSH_STATE_ALWAYS && !fFlushForPrune && !IsInitialBlockDownload()) {
+                size_t nEvicted = pcoinsTip->EvictClean(nTotalSpace * 3 / 4 / DB_PEAK_USAGE_FACTOR);
+                std::shared_ptr<CCoinsMap> pmapCoins = std::make_shared<CCoinsMap>();
+                const uint256 hashBestBlock = pcoinsTip->GetBestBlock();
+                pcoinsTip->SnapshotDirty(*pmapCoins);
+                LogPrint("coindb", "%s: evicted %u coins, writing %u modified coins in the background\n", __func__, (unsigned int)nEvicted, (unsigned int)pmapCoins->size());
+                // Flush the chainstate (which may refer to block index entries).
+                futureChainStateWrite = std::async(std::launch::async, [pmapCoins, hashBestBlock]() {
+                    RenameThread("cash-coinsflush");
+                    return pcoinsdbview->BatchWrite(*pmapCoins, hashBestBlock);
+                });
+            } else {
+                // Flush the chainstate (which may refer to block index entries).
+                if (!pcoinsTip->Flush())
+                    return AbortNode(state, "Failed to write to coin database");
+            }
             nLastFlush = nNow;
         }
         if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
@@ -3294,8 +3498,12 @@ void static UpdateTip(CBlockIndex* pindexNew, const CChainParams& chainParams)
         LogPrintf("%s -- warning='%s'\n", __func__, boost::algorithm::join(warningMessages, ", "));
 }
 
-/** Disconnect chainActive's tip. You probably want to call mempool.removeForReorg and manually re-limit mempool size after this, with cs_main held. */
-bool static DisconnectTip(CValidationState& state, const CChainParams& chainparams)
+/**
+ * Disconnect chainActive's tip. You probably want to call mempool.removeForReorg and manually re-limit mempool size after this, with cs_main held.
+ * With fRollback, the block's connection was never announced (its scripts failed deferred verification): its
+ * transactions are neither returned to the mempool nor reported to wallets as disconnected.
+ */
+bool static DisconnectTip(CValidationState& state, const CChainParams& chainparams, bool fRollback = false)
 {
 
     CBlockIndex* pindexDelete = chainActive.Tip();
@@ -3317,6 +3525,10 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
+    if (fRollback) {
+        UpdateTip(pindexDelete->pprev, chainparams);
+        return true;
+    }
     // Resurrect mempool transactions from the disconnected block.
     std::vector<uint256> vHashUpdate;
     for (const auto& it : block.vtx) {
@@ -3359,6 +3571,60 @@ struct ConnectTrace {
     std::vector<std::pair<CBlockIndex*, std::shared_ptr<const CBlock> > > blocksConnected;
 };
 
+/** Spent coins a block must miss in the cache per thread before they are read in parallel. */
+static const size_t MIN_PREFETCH_COINS = 64;
+
+/**
+ * Read the coins spent by a block that have no entry in the coins cache yet on
+ * the prefetch threads, and add them to pcoinsTip, so that ConnectBlock doesn't
+ * wait for one random database read after the other.
+ * The reads don't exclude a background chain state write (see
+ * FlushStateToDisk), which runs without cs_main, so they may see the database
+ * from before or after it. That is harmless: every coin the write touches keeps
+ * its cache entry, possibly a spent placeholder, until the write has landed,
+ * such outpoints are not read here, and CacheCoin never replaces an existing
+ * entry in any case.
+ */
+static void PrefetchBlockInputs(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    if (!nScriptCheckThreads)
+        return;
+    int64_t nTimeStart = GetTimeMicros();
+
+    std::set<uint256> setBlockTxids;
+    for (const auto& tx : block.vtx)
+        setBlockTxids.insert(tx->GetHash());
+    std::vector<COutPoint> vOutpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase())
+            continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (!setBlockTxids.count(txin.prevout.hash) && !pcoinsTip->HaveEntryInCache(txin.prevout))
+                vOutpoints.push_back(txin.prevout);
+        }
+    }
+    if (vOutpoints.size() < MIN_PREFETCH_COINS)
+        return;
+
+    std::vector<Coin> vCoins(vOutpoints.size());
+    std::vector<char> vFound(vOutpoints.size(), 0);
+    std::vector<CCoinPrefetch> vChecks;
+    vChecks.reserve(vOutpoints.size());
+    for (size_t i = 0; i < vOutpoints.size(); i++)
+        vChecks.push_back(CCoinPrefetch(vOutpoints[i], vCoins[i], vFound[i]));
+    CCheckQueueControl<CCoinPrefetch> control(&prefetchqueue);
+    control.Add(vChecks);
+    control.Wait();
+
+    size_t nCached = 0;
+    for (size_t i = 0; i < vOutpoints.size(); i++) {
+        if (vFound[i] && pcoinsTip->CacheCoin(vOutpoints[i], std::move(vCoins[i])))
+            nCached++;
+    }
+    LogPrint("bench", "  - Prefetch %u coins: %.2fms\n", (unsigned int)nCached, (GetTimeMicros() - nTimeStart) * 0.001);
+}
+
 /**
  * Connect a new block to chainActive. pblock is either NULL or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -3366,8 +3632,11 @@ struct ConnectTrace {
  * The block is always added to connectTrace (either after loading from disk or by copying
  * pblock) - if that is not intended, care must be taken to remove the last entry in
  * blocksConnected in case of failure.
+ *
+ * With pdeferred, the block's script checks join that window and BlockChecked is
+ * only signalled once they have been resolved.
  */
-bool static ConnectTip(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace)
+bool static ConnectTip(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, CDeferredScriptChecks* pdeferred = NULL)
 {
     assert(pindexNew->pprev == chainActive.Tip());
     // Read block from disk.
@@ -3386,15 +3655,21 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
+    PrefetchBlockInputs(blockConnecting);
     {
         CCoinsViewCache view(pcoinsTip);
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams);
-        GetMainSignals().BlockChecked(blockConnecting, state);
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams, false, pdeferred ? pdeferred->control.get() : NULL);
+        if (!rv || !pdeferred)
+            GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(pindexNew, state);
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
+        if (pdeferred) {
+            pdeferred->vBlocks.push_back(connectTrace.blocksConnected.back());
+            nDeferredScriptBlocks++;
+        }
         nTime3 = GetTimeMicros();
         nTimeConnectTotal += nTime3 - nTime2;
         LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
@@ -3423,6 +3698,54 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     return true;
 }
 
+/**
+ * Wait for the outstanding script checks of a window opened by ActivateBestChainStep.
+ * If they all passed, the window's blocks are marked BLOCK_VALID_SCRIPTS. Otherwise
+ * the whole window is rolled back without notifications (fScriptsOk is set to false),
+ * and scripts are verified per block until the tip is past the window again, so that
+ * the offending block is found through the regular invalid block handling. Returns
+ * false on a system error only.
+ */
+static bool ResolveDeferredScriptChecks(CValidationState& state, const CChainParams& chainparams, CDeferredScriptChecks& deferred, ConnectTrace& connectTrace, bool& fScriptsOk)
+{
+    AssertLockHeld(cs_main);
+    int64_t nTimeStart = GetTimeMicros();
+    fScriptsOk = deferred.control->Wait();
+    deferred.control.reset();
+    LogPrint("bench", "  - Verify scripts of %u deferred blocks: %.2fms\n", (unsigned int)deferred.vBlocks.size(), (GetTimeMicros() - nTimeStart) * 0.001);
+
+    if (fScriptsOk) {
+        CValidationState stateValid;
+        for (const auto& pair : deferred.vBlocks) {
+            CBlockIndex* pindex = pair.first;
+            if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
+                pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
+                setDirtyBlockIndex.insert(pindex);
+            }
+            GetMainSignals().BlockChecked(*pair.second, stateValid);
+        }
+        deferred.vBlocks.clear();
+        nDeferredScriptBlocks = 0;
+        return FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED);
+    }
+
+    // Keep nDeferredScriptBlocks set while rewinding, the remaining blocks are still unverified.
+    if (!deferred.vBlocks.empty()) {
+        const CBlockIndex* pindexWindowStart = deferred.vBlocks.front().first->pprev;
+        nDeferredScriptsFailedHeight = deferred.vBlocks.back().first->nHeight;
+        LogPrintf("%s: script verification failed between heights %d and %d, reconnecting those blocks one by one\n", __func__,
+            pindexWindowStart->nHeight + 1, nDeferredScriptsFailedHeight);
+        while (chainActive.Tip() != pindexWindowStart) {
+            if (!DisconnectTip(state, chainparams, true))
+                return false;
+        }
+    }
+    connectTrace.blocksConnected.resize(deferred.nTraceStart);
+    deferred.vBlocks.clear();
+    nDeferredScriptBlocks = 0;
+    return true;
+}
+
 bool DisconnectBlocks(int blocks)
 {
     LOCK(cs_main);
@@ -3543,6 +3866,7 @@ static void PruneBlockIndexCandidates()
  */
 static bool ActivateBestChainStep(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace)
 {
+    TRACE_SCOPE("validation", "ActivateBestChainStep");
     AssertLockHeld(cs_main);
     const CBlockIndex* pindexOldTip = chainActive.Tip();
     const CBlockIndex* pindexFork = chainActive.FindFork(pindexMostWork);
@@ -3555,6 +3879,15 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
         fBlocksDisconnected = true;
     }
 
+    // During initial block download the script checks of up to nScriptCheckDepth
+    // consecutive blocks are verified in one queue session, so that the workers keep
+    // verifying while the following blocks are applied to the UTXO set. The window
+    // is always resolved before this function returns. Importing and reindexing
+    // count as initial block download here even once IsInitialBlockDownload latched.
+    bool fDeferScripts = nScriptCheckThreads && nScriptCheckDepth > 1 && chainActive.Height() >= nDeferredScriptsFailedHeight &&
+                         (fImporting || fReindex || IsInitialBlockDownload());
+    CDeferredScriptChecks deferred;
+
     // Build list of new blocks to connect.
     std::vector<CBlockIndex*> vpindexToConnect;
     bool fContinue = true;
@@ -3574,7 +3907,30 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
 
         // Connect new blocks.
         BOOST_REVERSE_FOREACH (CBlockIndex* pindexConnect, vpindexToConnect) {
-            if (!ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace)) {
+            if (fDeferScripts && !deferred.control) {
+                deferred.control.reset(new CCheckQueueControl<CScriptCheck>(&scriptcheckqueue));
+                deferred.nTraceStart = connectTrace.blocksConnected.size();
+            }
+            bool fConnected = ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, fDeferScripts ? &deferred : NULL);
+            if (fDeferScripts && (!fConnected || pindexConnect == pindexMostWork || deferred.vBlocks.size() >= (size_t)nScriptCheckDepth)) {
+                CValidationState stateResolve;
+                bool fScriptsOk = true;
+                if (!ResolveDeferredScriptChecks(stateResolve, chainparams, deferred, connectTrace, fScriptsOk)) {
+                    state = stateResolve;
+                    return false;
+                }
+                if (!fScriptsOk) {
+                    fBlocksDisconnected = true;
+                    if (!fConnected && !state.IsInvalid())
+                        return false;
+                    // Redo the window with per-block verification.
+                    state = CValidationState();
+                    fDeferScripts = false;
+                    nHeight = chainActive.Height();
+                    break;
+                }
+            }
+            if (!fConnected) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (!state.CorruptionPossible())
@@ -3589,6 +3945,10 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
                 }
             } else {
                 PruneBlockIndexCandidates();
+                if (deferred.control) {
+                    // Keep filling the script check window before releasing the lock.
+                    continue;
+                }
                 if (!pindexOldTip || chainActive.Tip()->nChainWork > pindexOldTip->nChainWork) {
                     // We're in a better position than we were. Return temporarily to release the lock.
                     fContinue = false;
@@ -3598,6 +3958,8 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
         }
     }
 
+    assert(!deferred.control);
+
     if (fBlocksDisconnected) {
         mempool.removeForReorg(pcoinsTip, chainActive.Tip()->nHeight + 1, STANDARD_LOCKTIME_VERIFY_FLAGS);
         LimitMempoolSize(mempool, GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
@@ -4038,8 +4400,11 @@ bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigne
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
-        return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
+    if (fCheckPOW) {
+        TRACE_SCOPE("pow", "CheckProofOfWork");
+        if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+            return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
+    }
 
     return true;
 }
@@ -4690,7 +5055,7 @@ CBlockIndex* InsertBlockIndex(uint256 hash)
 
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
-    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
+    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex, [](size_t nEntries) { mapBlockIndex.reserve(mapBlockIndex.size() + nEntries); }))
         return false;
 
     boost::this_thread::interruption_point();
@@ -4816,6 +5181,46 @@ CVerifyDB::~CVerifyDB()
     uiInterface.ShowProgress("", 100);
 }
 
+/** A block read ahead of the VerifyDB walk */
+struct CVerifyDBBlock {
+    const CBlockIndex* pindex;
+    CBlock block;
+    bool fRead;
+    bool fHeaderHashValid;
+
+    explicit CVerifyDBBlock(const CBlockIndex* pindexIn) : pindex(pindexIn), fRead(false), fHeaderHashValid(false) {}
+};
+
+/**
+ * Read a batch of blocks from disk and, if requested, recompute the Argon2d
+ * hash of their headers on nThreads threads. Reading trusts the index hash, so
+ * this is where VerifyDB actually checks the proof of work. Neither step needs
+ * cs_main, the remaining checks stay on the calling thread.
+ */
+static void ReadBlocksForVerifyDB(std::vector<CVerifyDBBlock>& vBlocks, bool fCheckHeaderHash, int nThreads, const Consensus::Params& consensusParams)
+{
+    std::atomic<size_t> nNext(0);
+    auto readBlocks = [&]() {
+        for (size_t i = nNext++; i < vBlocks.size(); i = nNext++) {
+            CVerifyDBBlock& entry = vBlocks[i];
+            entry.fRead = ReadBlockFromDisk(entry.block, entry.pindex, consensusParams);
+            if (entry.fRead && fCheckHeaderHash)
+                entry.fHeaderHashValid = entry.pindex->GetBlockHeader().GetHash() == entry.pindex->GetBlockHash();
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nThreads && (size_t)i < vBlocks.size(); i++) {
+        vThreads.emplace_back([&]() {
+            Argon2dSetThreadParallel(false);
+            readBlocks();
+        });
+    }
+    readBlocks();
+    for (std::thread& thread : vThreads)
+        thread.join();
+}
+
 bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView* coinsview, int nCheckLevel, int nCheckDepth)
 {
     LOCK(cs_main);
@@ -4835,6 +5240,11 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView* coinsview,
     int nGoodTransactions = 0;
     CValidationState state;
     int reportDone = 0;
+    // Blocks are read and their headers hashed in batches across the -par threads
+    const int nThreads = std::max(1, nScriptCheckThreads);
+    const size_t nBatchSize = 4 * nThreads;
+    std::vector<CVerifyDBBlock> vBatch;
+    size_t nBatchPos = 0;
     LogPrintf("[0%%]...");
     for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
         boost::this_thread::interruption_point();
@@ -4852,11 +5262,28 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView* coinsview,
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
-        CBlock block;
+        if (nBatchPos == vBatch.size()) {
+            vBatch.clear();
+            vBatch.reserve(nBatchSize);
+            nBatchPos = 0;
+            for (const CBlockIndex* pindexRead = pindex; pindexRead && pindexRead->pprev && vBatch.size() < nBatchSize; pindexRead = pindexRead->pprev) {
+                if (pindexRead->nHeight < chainActive.Height() - nCheckDepth)
+                    break;
+                if (fPruneMode && !(pindexRead->nStatus & BLOCK_HAVE_DATA))
+                    break;
+                vBatch.emplace_back(pindexRead);
+            }
+            ReadBlocksForVerifyDB(vBatch, nCheckLevel >= 1, nThreads, chainparams.GetConsensus());
+        }
+        assert(vBatch[nBatchPos].pindex == pindex);
+        const CVerifyDBBlock& entry = vBatch[nBatchPos++];
+        const CBlock& block = entry.block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+        if (!entry.fRead)
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 1: verify block validity
+        if (nCheckLevel >= 1 && !entry.fHeaderHashValid)
+            return error("VerifyDB(): *** block header hash mismatch at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus()))
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
                 pindex->nHeight, pindex->GetBlockHash().ToString(), FormatStateMessage(state));
@@ -90,6 +90,10 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x600000; // 6 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 64;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** -scriptcheckdepth default (blocks whose script checks may be outstanding during initial block download) */
+static const int DEFAULT_SCRIPT_CHECK_DEPTH = 16;
+/** Maximum value accepted for -scriptcheckdepth */
+static const int MAX_SCRIPT_CHECK_DEPTH = 256;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 96;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -142,6 +146,8 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 60 * 60;
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const unsigned int DEFAULT_BYTES_PER_SIGOP = 20;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
+/** Default for -incrementalflush, write the chain state in the background and keep the coins cache warm */
+static const bool DEFAULT_INCREMENTAL_FLUSH = true;
 static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
@@ -185,6 +191,7 @@ extern uint256 g_best_block;
 extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
+extern int nScriptCheckDepth;
 extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
@@ -192,6 +199,7 @@ extern bool fStealthTx;
 extern unsigned int nBytesPerSigOp;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
+extern bool fIncrementalFlush;
 extern size_t nCoinCacheUsage;
 /** A fee rate smaller than this is considered zero fee (for relaying, mining and transaction creation) */
 extern CFeeRate minRelayTxFee;
@@ -282,6 +290,17 @@ bool LoadBlockIndex(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the header proof-of-work checking thread */
+void ThreadHeaderCheck();
+/** Run an instance of the thread reading coins ahead of block connection */
+void ThreadCoinPrefetch();
+/**
+ * Check the proof of work of a batch of headers on the header checking threads.
+ * Does not require cs_main. The computed hashes stay cached on the headers, so
+ * a following ProcessNewBlockHeaders does not hash them again.
+ * Returns false if any header fails its proof of work.
+ */
+bool CheckBlockHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.